@@ -0,0 +1,146 @@
+#include <iomanip>
+
+#include "accounting.hpp"
+
+namespace {
+    std::atomic<bool> tracking(false);
+    thread_local open_json::accounting::account *active_account = nullptr;
+    
+    // Keeps the allocation aligned for any type
+    typedef struct alignas(16) allocation_header {
+        open_json::accounting::account *owner;
+        uint32_t size;
+        uint16_t type;
+        uint16_t objects;
+    } allocation_header;
+    static_assert(sizeof(allocation_header) == 16, "Tracked allocations expect a 16 byte header");
+    
+    const char *const kind_names[] = {"objects", "vertices", "attributes", "strings"};
+};
+
+open_json::accounting::account::account(const std::string &account_name) : name(account_name), references(1), objects(0), peak_bytes(0) {
+    for (size_t i = 0; i < kind_count; i++) {
+        this->bytes[i] = 0;
+    }
+}
+
+open_json::accounting::account *open_json::accounting::account::create(const std::string &name) {
+    return new account(name);
+}
+
+void open_json::accounting::account::release() {
+    if (this->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+void open_json::accounting::account::add(kind type, int64_t byte_count, int64_t object_count) {
+    this->bytes[static_cast<size_t>(type)].fetch_add(byte_count, std::memory_order_relaxed);
+    this->objects.fetch_add(object_count, std::memory_order_relaxed);
+    if (byte_count > 0) {
+        // Approximate under concurrent updates, good enough for a report
+        int64_t total = this->get_total_bytes(), peak = this->peak_bytes.load(std::memory_order_relaxed);
+        while (total > peak && !this->peak_bytes.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {}
+    }
+}
+
+int64_t open_json::accounting::account::get_total_bytes() const {
+    int64_t total = 0;
+    for (size_t i = 0; i < kind_count; i++) {
+        total += this->bytes[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void open_json::accounting::enable_tracking() {
+    tracking = true;
+}
+
+bool open_json::accounting::is_tracking() {
+    return tracking.load(std::memory_order_relaxed);
+}
+
+open_json::accounting::account *open_json::accounting::current_account() {
+    return active_account;
+}
+
+open_json::accounting::account_scope::account_scope(account *active) : previous(active_account) {
+    active_account = active;
+}
+
+open_json::accounting::account_scope::~account_scope() {
+    active_account = this->previous;
+}
+
+void *open_json::accounting::allocate(size_t size, kind type, int64_t objects) {
+    if (!is_tracking()) {
+        return ::operator new(size);
+    }
+    allocation_header *header = static_cast<allocation_header*>(::operator new(size + sizeof(allocation_header)));
+    header->owner = active_account;
+    header->size = static_cast<uint32_t>(size);
+    header->type = static_cast<uint16_t>(type);
+    header->objects = static_cast<uint16_t>(objects);
+    if (header->owner != nullptr) {
+        header->owner->retain();
+        header->owner->add(type, static_cast<int64_t>(size), objects);
+    }
+    return header + 1;
+}
+
+void open_json::accounting::deallocate(void *memory) {
+    if (memory == nullptr) {
+        return;
+    }
+    if (!is_tracking()) {
+        ::operator delete(memory);
+        return;
+    }
+    allocation_header *header = static_cast<allocation_header*>(memory) - 1;
+    if (header->owner != nullptr) {
+        header->owner->add(static_cast<kind>(header->type), -static_cast<int64_t>(header->size), -static_cast<int64_t>(header->objects));
+        header->owner->release();
+    }
+    ::operator delete(header);
+}
+
+open_json::accounting::design_usage::~design_usage() {
+    for (auto &entry : this->accounts) {
+        entry.second->release();
+    }
+}
+
+open_json::accounting::account *open_json::accounting::design_usage::get_account(const std::string &section) {
+    account *&entry = this->accounts[section];
+    if (entry == nullptr) {
+        entry = account::create(section);
+    }
+    return entry;
+}
+
+void open_json::accounting::design_usage::print_report(std::ostream &out) const {
+    out<<"Memory of "<<this->design_name<<" (live bytes per section):"<<std::endl;
+    out<<"  "<<std::left<<std::setw(26)<<"section"<<std::right<<std::setw(10)<<"objects";
+    for (const char *name : kind_names) {
+        out<<std::setw(14)<<name;
+    }
+    out<<std::setw(14)<<"total"<<std::setw(14)<<"peak"<<std::endl;
+    int64_t totals[kind_count] = {0, 0, 0, 0}, objects = 0, total = 0, peak = 0;
+    for (const auto &entry : this->accounts) {
+        const account &section = *entry.second;
+        out<<"  "<<std::left<<std::setw(26)<<section.get_name()<<std::right<<std::setw(10)<<section.get_objects();
+        for (size_t i = 0; i < kind_count; i++) {
+            out<<std::setw(14)<<section.get_bytes(static_cast<kind>(i));
+            totals[i] += section.get_bytes(static_cast<kind>(i));
+        }
+        out<<std::setw(14)<<section.get_total_bytes()<<std::setw(14)<<section.get_peak_bytes()<<std::endl;
+        objects += section.get_objects();
+        total += section.get_total_bytes();
+        peak += section.get_peak_bytes();
+    }
+    out<<"  "<<std::left<<std::setw(26)<<"all sections"<<std::right<<std::setw(10)<<objects;
+    for (size_t i = 0; i < kind_count; i++) {
+        out<<std::setw(14)<<totals[i];
+    }
+    out<<std::setw(14)<<total<<std::setw(14)<<peak<<std::endl;
+}
@@ -0,0 +1,221 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <sys/resource.h>
+
+#include "generator.hpp"
+#include "library.hpp"
+#include "openjson.hpp"
+#include "parallel.hpp"
+#include "scan.hpp"
+#include "serialize.hpp"
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+    
+    typedef struct phase_result {
+        std::string name;
+        size_t bytes = 0, objects = 0;
+        double min_seconds = 0.0, total_seconds = 0.0;
+        size_t runs = 0;
+    } phase_result;
+    
+    // Runs the phase the given number of times, the fastest run is used for the throughput figures
+    template<typename function_type>
+    phase_result measure(const std::string &name, size_t iterations, size_t bytes, size_t objects, function_type function) {
+        phase_result result;
+        result.name = name;
+        result.bytes = bytes;
+        result.objects = objects;
+        for (size_t i = 0; i < iterations; i++) {
+            // Parse diagnostics are the same on every run and would only drown the results
+            open_json::diagnostic_capture discarded;
+            open_json::diagnostic_capture::scope scope(discarded);
+            clock_type::time_point start = clock_type::now();
+            function();
+            double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+            result.min_seconds = i == 0 ? seconds : std::min(result.min_seconds, seconds);
+            result.total_seconds += seconds;
+            result.runs++;
+        }
+        std::cerr<<"  "<<std::left<<std::setw(12)<<name<<std::right<<std::fixed<<std::setprecision(3)
+                 <<result.min_seconds * 1000.0<<" ms, "<<result.bytes / result.min_seconds / 1e6<<" MB/s, "
+                 <<static_cast<size_t>(result.objects / result.min_seconds)<<" objects/s"<<std::endl;
+        return result;
+    }
+    
+    size_t count_objects(open_json::data &design) {
+        size_t objects = design.get_components().size() + design.get_component_instances().size() + design.get_nets().size() + design.get_layer_options().size()
+            + design.get_layout_bodies().size() + design.get_layout_body_attributes().size() + design.get_layout_objects().size() + design.get_pcb_text().size()
+            + design.get_pours().size() + design.get_traces().size() + design.get_paths().size();
+        return objects;
+    }
+    
+    std::vector<json> lex_copies(const std::string &text, size_t count) {
+        std::vector<json> copies(count);
+        for (json &copy : copies) {
+            copy = json::parse(text);
+        }
+        return copies;
+    }
+    
+    uint64_t get_peak_rss() {
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+        // Kilobytes on Linux
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    }
+    
+    void print_usage() {
+        std::cerr<<"Usage: bench [--components=N] [--instances=N] [--nets=N] [--pins-per-net=N] [--traces=N] [--pours=N] [--pour-vertices=N]"<<std::endl
+                 <<"             [--seed=N] [--legacy] [--iterations=N] [--component-cache=N] [--output=results.json] [--write-design=design.upv]"<<std::endl
+                 <<"Measures lexing, decoding, decoding with the 0.1.x upgrade, serialization and end to end conversion of a generated design."<<std::endl
+                 <<"Results are written as JSON to stdout or the output file, the component cache is off unless given a size."<<std::endl;
+    }
+};
+
+int main(int argc, char **argv) {
+    open_json::bench::generator_options design_options;
+    size_t iterations = 5, component_cache_entries = 0;
+    std::string output_file, design_file;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        size_t separator = argument.find('=');
+        std::string name = argument.substr(2, separator == std::string::npos ? std::string::npos : separator - 2);
+        std::string value = separator == std::string::npos ? "" : argument.substr(separator + 1);
+        if (argument.find("--") != 0) {
+            print_usage();
+            return EXIT_FAILURE;
+        } else if (name == "legacy") {
+            design_options.legacy = true;
+        } else if (name == "output") {
+            output_file = value;
+        } else if (name == "write-design") {
+            design_file = value;
+        } else if (name == "iterations" || name == "component-cache") {
+            try {
+                (name == "iterations" ? iterations : component_cache_entries) = std::stoul(value);
+            } catch (...) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (!open_json::bench::parse_generator_option(name, value, design_options)) {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+    iterations = std::max<size_t>(iterations, 1);
+    open_json::library::component_cache::shared().set_capacity(component_cache_entries);
+    
+    open_json::bench::generator_options legacy_options = design_options;
+    legacy_options.legacy = true;
+    std::string text = open_json::bench::generate_design(design_options).dump();
+    std::string legacy_text = open_json::bench::generate_design(legacy_options).dump();
+    if (!design_file.empty()) {
+        std::ofstream out(design_file, std::ios::binary);
+        out<<text;
+        return out ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    size_t objects = 0, legacy_objects = 0, output_bytes = 0;
+    std::shared_ptr<open_json::data> design;
+    {
+        open_json::diagnostic_capture discarded;
+        open_json::diagnostic_capture::scope scope(discarded);
+        design = std::make_shared<open_json::data>("bench", json::parse(text));
+        objects = count_objects(*design);
+        legacy_objects = count_objects(*std::make_shared<open_json::data>("bench", json::parse(legacy_text)));
+        std::ostringstream rendered;
+        open_json::serialize::write(rendered, *design);
+        output_bytes = rendered.str().size();
+    }
+    std::cerr<<"Design: "<<text.size()<<" bytes, "<<objects<<" objects ("<<legacy_text.size()<<" bytes as 0.1.x), "<<iterations<<" iterations, "
+             <<open_json::parallel::get_concurrency()<<" threads"<<std::endl;
+    
+    std::vector<phase_result> phases;
+    phases.push_back(measure("lex", iterations, text.size(), objects, [&]() {
+        json::parse(text);
+    }));
+    phases.push_back(measure("index", iterations, text.size(), objects, [&]() {
+        open_json::scan::structural_index index(text);
+    }));
+    phases.push_back(measure("chunked_lex", iterations, text.size(), objects, [&]() {
+        open_json::scan::parse_document(text);
+    }));
+    // Lexed up front so only building the design is timed, every run consumes its own copy
+    std::vector<json> lexed = lex_copies(text, iterations);
+    phases.push_back(measure("decode", iterations, text.size(), objects, [&]() {
+        open_json::data decoded("bench", std::move(lexed.back()));
+        lexed.pop_back();
+    }));
+    lexed = lex_copies(legacy_text, iterations);
+    phases.push_back(measure("upgrade", iterations, legacy_text.size(), legacy_objects, [&]() {
+        open_json::data upgraded("bench", std::move(lexed.back()));
+        lexed.pop_back();
+    }));
+    phases.push_back(measure("serialize", iterations, output_bytes, objects, [&]() {
+        std::ostringstream out;
+        open_json::serialize::write(out, *design);
+    }));
+    phases.push_back(measure("end_to_end", iterations, text.size(), objects, [&]() {
+        open_json::open_json_format format;
+        std::ostringstream out;
+        format.write_stream(*format.read_buffer("bench.upv", text), output_type::ALL, out);
+    }));
+    // A bill of materials only needs the parts, the other sections stay undecoded
+    phases.push_back(measure("lazy_bom", iterations, text.size(), design->get_components().size() + design->get_component_instances().size(), [&]() {
+        open_json::open_json_format format;
+        std::istringstream input(text);
+        format.read_file_lazy("bench.upv", input)->get_component_instances();
+    }));
+    
+    json results = {
+        {"design", {
+            {"components", design_options.components},
+            {"instances", design_options.instances},
+            {"nets", design_options.nets},
+            {"pins_per_net", design_options.pins_per_net},
+            {"traces", design_options.traces},
+            {"pours", design_options.pours},
+            {"pour_vertices", design_options.pour_vertices},
+            {"legacy", design_options.legacy},
+            {"seed", design_options.seed},
+            {"bytes", text.size()},
+            {"legacy_bytes", legacy_text.size()},
+            {"output_bytes", output_bytes},
+            {"objects", objects}
+        }},
+        {"iterations", iterations},
+        {"threads", open_json::parallel::get_concurrency()},
+        {"phases", json::value_t::object},
+        {"peak_rss_bytes", get_peak_rss()}
+    };
+    for (const phase_result &phase : phases) {
+        results["phases"][phase.name] = {
+            {"min_seconds", phase.min_seconds},
+            {"mean_seconds", phase.total_seconds / phase.runs},
+            {"bytes", phase.bytes},
+            {"objects", phase.objects},
+            {"mb_per_second", phase.bytes / phase.min_seconds / 1e6},
+            {"objects_per_second", phase.objects / phase.min_seconds}
+        };
+    }
+    
+    if (output_file.empty()) {
+        std::cout<<std::setw(4)<<results<<std::endl;
+    } else {
+        std::ofstream out(output_file);
+        out<<std::setw(4)<<results<<std::endl;
+        if (!out) {
+            std::cerr<<"Couldn't write the results to "<<output_file<<std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Builds every release profile and times the converter on the same synthetic designs, speedups are relative to make release.
+# Usage: bench/compare_profiles.sh [runs] [generator options], e.g. bench/compare_profiles.sh 5 --traces=200000
+# CXX and CC are passed on to make.
+set -e
+cd "$(dirname "$0")/.."
+RUNS=${1:-3}
+[ $# -gt 0 ] && shift
+DESIGN_ARGS=${*:-"--components=500 --instances=10000 --nets=5000 --traces=100000 --pours=200"}
+PROFILES="release portable thinlto pgo"
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+MAKE_ARGS=""
+[ -n "$CXX" ] && MAKE_ARGS="$MAKE_ARGS CXX=$CXX"
+[ -n "$CC" ] && MAKE_ARGS="$MAKE_ARGS CC=$CC"
+mkdir -p obj bin
+
+# The corpus is written by an ordinary release build so every profile converts the same bytes
+make clean > /dev/null
+make bench $MAKE_ARGS BENCH_ARGS="--iterations=1 --write-design=$WORK/design.upv $DESIGN_ARGS" > /dev/null
+./bin/bench --legacy --write-design="$WORK/legacy.upv" $DESIGN_ARGS
+
+now() {
+    date +%s%N
+}
+
+# Best of the runs in milliseconds
+time_converter() {
+    best=""
+    run=0
+    while [ $run -lt "$RUNS" ]; do
+        start=$(now)
+        (cd "$WORK" && "$1" design.upv legacy.upv > /dev/null)
+        elapsed=$(( ($(now) - start) / 1000000 ))
+        if [ -z "$best" ] || [ $elapsed -lt "$best" ]; then
+            best=$elapsed
+        fi
+        run=$((run + 1))
+    done
+    echo "$best"
+}
+
+baseline=""
+printf "%-10s %10s %8s\n" profile "best ms" speedup
+for profile in $PROFILES; do
+    make clean > /dev/null
+    make $profile $MAKE_ARGS > "$WORK/build_$profile.log" 2>&1 || { echo "$profile: build failed, see the log below"; cat "$WORK/build_$profile.log"; exit 1; }
+    cp bin/converter "$WORK/converter_$profile"
+    elapsed=$(time_converter "$WORK/converter_$profile")
+    [ -z "$baseline" ] && baseline=$elapsed
+    printf "%-10s %10d %8s\n" "$profile" "$elapsed" "$(awk -v base="$baseline" -v elapsed="$elapsed" 'BEGIN { printf "%.2fx", (elapsed > 0 ? base / elapsed : 0) }')"
+done
+make clean > /dev/null
@@ -0,0 +1,186 @@
+#include <random>
+
+#include "generator.hpp"
+
+namespace {
+    const char *const copper_layers[] = {"top copper", "bottom copper"};
+    const size_t pins_per_component = 8;
+    
+    class design_generator {
+    private:
+        const open_json::bench::generator_options &options;
+        std::mt19937_64 random;
+        
+        int64_t coordinate(int64_t range = 100000000) {
+            return std::uniform_int_distribution<int64_t>(-range, range)(this->random);
+        }
+        
+        json point(int64_t range = 100000000) {
+            return json({{"x", this->coordinate(range)}, {"y", this->coordinate(range)}});
+        }
+        
+        json polygon(size_t vertices, int64_t range) {
+            json points(json::value_t::array), shape_types(json::value_t::array);
+            for (size_t i = 0; i < vertices; i++) {
+                points.push_back(this->point(range));
+                shape_types.push_back("line");
+            }
+            return json({{"type", "polygon"}, {"points", points}, {"shape_types", shape_types}, {"line_width", 0}});
+        }
+        
+        json shapes() {
+            json shape_list(json::value_t::array);
+            shape_list.push_back({{"type", "rectangle"}, {"x", 0}, {"y", 0}, {"width", 100000}, {"height", 50000}, {"line_width", 1000}});
+            shape_list.push_back({{"type", "arc"}, {"x", 1000}, {"y", 2000}, {"radius", 50000}, {"start_angle", 0.0}, {"end_angle", 1.5}, {"width", 2000}, {"is_clockwise", false}});
+            shape_list.push_back({{"type", "circle"}, {"x", 5}, {"y", 5}, {"radius", 30000}, {"line_width", 10}});
+            shape_list.push_back({{"type", "line"}, {"p1", this->point(500000)}, {"p2", this->point(500000)}, {"width", 1000}});
+            shape_list.push_back({{"type", "bezier"}, {"p1", this->point(500000)}, {"p2", this->point(500000)}, {"control1", this->point(500000)}, {"control2", this->point(500000)}});
+            shape_list.push_back(this->polygon(6, 500000));
+            return shape_list;
+        }
+        
+        // Pins in 0.1.x files, action regions afterwards
+        json body(const std::string &layer) {
+            json regions(json::value_t::array);
+            for (size_t pin = 1; pin <= pins_per_component; pin++) {
+                std::string number = std::to_string(pin);
+                if (this->options.legacy) {
+                    regions.push_back({{"pin_number", number}, {"label", {{"text", number}, {"x", 0}, {"y", static_cast<int64_t>(pin) * 100000}}}});
+                } else {
+                    regions.push_back({{"name", number}, {"ref", number}, {"p1", this->point(500000)}, {"p2", this->point(500000)}, {"connections", json::value_t::array}});
+                }
+            }
+            json result = {{"shapes", this->shapes()}, {this->options.legacy ? "pins" : "action_regions", regions}};
+            if (!layer.empty()) {
+                result["layer"] = layer;
+            }
+            return result;
+        }
+        
+        json component(size_t index) {
+            json annotation = {{"x", 1}, {"y", 2}, {"label", {{"text", "U?"}, {"x", 1}, {"y", 2}}}};
+            json symbol_body = this->body("");
+            symbol_body["annotations"] = json::array({annotation});
+            return {
+                {"name", "C" + std::to_string(index)},
+                {"attributes", {{"manufacturer", "generated"}, {"value", std::to_string(index)}}},
+                {"footprints", json::array({{{"bodies", json::array({this->body("top copper")})}, {"gen_objs", json::value_t::array}}})},
+                {"symbols", json::array({{{"bodies", json::array({symbol_body})}}})}
+            };
+        }
+        
+        json component_instance(size_t index) {
+            static const double rotations[] = {0.0, 0.5, 1.0, 1.5};
+            return {
+                {"library_id", "lib" + std::to_string(index % this->options.components)},
+                {"instance_id", "inst" + std::to_string(index)},
+                {"symbol_index", 0},
+                {"footprint_index", 0},
+                {"footprint_pos", {{"x", this->coordinate()}, {"y", this->coordinate()}, {"rotation", rotations[this->random() % 4]}, {"flip", false}, {"side", this->random() % 8 == 0 ? "bottom" : "top"}}},
+                {"symbol_attributes", json::array({{{"x", 100}, {"y", 200}, {"rotation", 0}, {"flip", false}, {"hidden", false}, {"annotations", json::value_t::array}}})},
+                {"footprint_attributes", json::array({{{"x", 1}, {"y", 1}, {"layer", "top silkscreen"}, {"rotation", 0}, {"flip", false}}})},
+                {"gen_obj_attributes", json::value_t::array},
+                {"attributes", {{"refdes", "U" + std::to_string(index)}}}
+            };
+        }
+        
+        // A chain of points, each connected to its neighbours and to one pin of a random instance
+        json net(size_t index) {
+            std::string id = "net" + std::to_string(index);
+            json points(json::value_t::array);
+            for (size_t i = 0; i < this->options.pins_per_net; i++) {
+                std::string instance = "inst" + std::to_string(this->random() % this->options.instances);
+                size_t pin = this->random() % pins_per_component;
+                json connected(json::value_t::array);
+                if (i > 0) {
+                    connected.push_back(id + "_" + std::to_string(i - 1));
+                }
+                if (i + 1 < this->options.pins_per_net) {
+                    connected.push_back(id + "_" + std::to_string(i + 1));
+                }
+                json net_point = {{"point_id", id + "_" + std::to_string(i)}, {"x", this->coordinate()}, {"y", this->coordinate()}, {"connected_points", connected}};
+                if (this->options.legacy) {
+                    net_point["connected_components"] = json::array({{{"instance_id", instance}, {"pin_number", std::to_string(pin + 1)}}});
+                } else {
+                    net_point["connected_action_regions"] = json::array({{{"instance_id", instance}, {"body_index", 0}, {"action_region_index", pin}, {"order", 0}, {"signal", ""}}});
+                }
+                points.push_back(net_point);
+            }
+            return {{"net_id", id}, {"net_type", "nets"}, {"attributes", json::value_t::object}, {"annotations", json::value_t::array}, {"signals", json::array({"S" + std::to_string(index)})}, {"points", points}};
+        }
+        
+        json pour(size_t index) {
+            json outline = this->polygon(this->options.pour_vertices, 10000000);
+            json polygons = {{"type", "general_polygon"}, {"outline", {{"points", outline["points"]}}}, {"holes", json::array({{{"points", this->polygon(4, 1000000)["points"]}}})}, {"points", json::value_t::array}, {"shape_types", json::value_t::array}};
+            return {
+                {"layer", copper_layers[index % 2]},
+                {"attached_net", this->options.nets > 0 ? "net" + std::to_string(index % this->options.nets) : ""},
+                {"points", outline["points"]},
+                {"shape_types", outline["shape_types"]},
+                {"polygons", polygons}
+            };
+        }
+    public:
+        explicit design_generator(const open_json::bench::generator_options &generator_options) : options(generator_options), random(generator_options.seed) {}
+        
+        json generate() {
+            json design = {{"version", {{"file_version", this->options.legacy ? "0.1.0" : "0.2.0"}, {"exporter", "open_json bench generator"}}}};
+            design["components"] = json::value_t::object;
+            for (size_t i = 0; i < this->options.components; i++) {
+                design["components"]["lib" + std::to_string(i)] = this->component(i);
+            }
+            design["component_instances"] = json::value_t::array;
+            for (size_t i = 0; i < this->options.instances && this->options.components > 0; i++) {
+                design["component_instances"].push_back(this->component_instance(i));
+            }
+            design["nets"] = json::value_t::array;
+            for (size_t i = 0; i < this->options.nets && this->options.instances > 0 && this->options.components > 0; i++) {
+                design["nets"].push_back(this->net(i));
+            }
+            design["layer_options"] = json::array({{{"ident", "top copper"}, {"name", "top copper"}, {"is_copper", true}}, {{"ident", "bottom copper"}, {"name", "bottom copper"}, {"is_copper", true}}});
+            design["layout_bodies"] = json::array({{{"layer", "top copper"}, {"shapes", this->shapes()}}});
+            design["layout_body_attributes"] = json::array({{{"layer", "top copper"}, {"x", 1}, {"y", 2}}});
+            design["layout_objects"] = json::value_t::array;
+            design["pcb_text"] = json::array({{{"layer", "top silkscreen"}, {"x", 10}, {"y", 10}, {"label", {{"text", "generated"}, {"x", 10}, {"y", 10}}}}});
+            design["pours"] = json::value_t::array;
+            for (size_t i = 0; i < this->options.pours; i++) {
+                design["pours"].push_back(this->pour(i));
+            }
+            design["trace_segments"] = json::value_t::array;
+            for (size_t i = 0; i < this->options.traces; i++) {
+                design["trace_segments"].push_back({{"layer", copper_layers[this->random() % 2]}, {"p1", this->point()}, {"p2", this->point()}, {"width", 254000}, {"control_points", json::value_t::array}});
+            }
+            design["paths"] = json::array({{{"layer", "board outline"}, {"points", json::array({{{"x", 0}, {"y", 0}}, {{"x", 100000000}, {"y", 0}}, {{"x", 100000000}, {"y", 100000000}}, {{"x", 0}, {"y", 100000000}}})}, {"shape_types", json::array({"line", "line", "line", "line"})}, {"width", 1000}, {"is_closed", true}}});
+            return design;
+        }
+    };
+};
+
+json open_json::bench::generate_design(const generator_options &options) {
+    return design_generator(options).generate();
+}
+
+bool open_json::bench::parse_generator_option(const std::string &name, const std::string &value, generator_options &options) {
+    std::map<std::string, size_t*> counts = {
+        {"components", &options.components},
+        {"instances", &options.instances},
+        {"nets", &options.nets},
+        {"pins-per-net", &options.pins_per_net},
+        {"traces", &options.traces},
+        {"pours", &options.pours},
+        {"pour-vertices", &options.pour_vertices}
+    };
+    try {
+        if (counts.find(name) != counts.end()) {
+            *counts[name] = std::stoul(value);
+            return true;
+        }
+        if (name == "seed") {
+            options.seed = std::stoull(value);
+            return true;
+        }
+    } catch (...) {
+        return false;
+    }
+    return false;
+}
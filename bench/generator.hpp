@@ -0,0 +1,31 @@
+#ifndef __GENERATOR__
+#define __GENERATOR__
+
+#include <cstdint>
+#include <string>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace bench {
+        typedef struct generator_options {
+            size_t components = 50;
+            size_t instances = 2000;
+            size_t nets = 1000;
+            size_t pins_per_net = 3;
+            size_t traces = 20000;
+            size_t pours = 50;
+            size_t pour_vertices = 64;
+            bool legacy = false; // 0.1.x layout, pins instead of action regions and nets connected by pin number
+            uint64_t seed = 1;
+        } generator_options;
+        
+        // Deterministic for the same options, every instance, net and pour refers to objects that exist in the design
+        json generate_design(const generator_options &options);
+        
+        // Takes name=value, returns false for names it doesn't know or values that aren't numbers
+        bool parse_generator_option(const std::string &name, const std::string &value, generator_options &options);
+    };
+};
+
+#endif /* defined(__GENERATOR__) */
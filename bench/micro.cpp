@@ -0,0 +1,209 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#include "generator.hpp"
+#include "library.hpp"
+#include "openjson.hpp"
+
+// Every allocation in the process is counted, the harness reads the counter around the timed loops
+namespace {
+    std::atomic<size_t> allocation_count(0);
+};
+
+void *operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+    typedef std::shared_ptr<open_json::types::json_object> object_pointer;
+    
+    // read constructs an object from the fragment the way its section reader does, get_json is then timed on one of them
+    typedef struct micro_case {
+        std::string name;
+        json fragment;
+        std::function<object_pointer(const json &)> read;
+    } micro_case;
+    
+    typedef struct measurement {
+        size_t objects = 0;
+        double nanoseconds = 0.0, allocations = 0.0; // Per object
+    } measurement;
+    
+    // Runs batches of growing size until one takes at least min_seconds, that batch is reported.
+    // Cleanup runs after every batch outside the timed region.
+    template<typename function_type, typename cleanup_type>
+    measurement measure(double min_seconds, function_type function, cleanup_type cleanup) {
+        measurement result;
+        for (size_t count = 16;; count *= 2) {
+            size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+            clock_type::time_point start = clock_type::now();
+            function(count);
+            double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+            size_t allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+            cleanup();
+            if (seconds >= min_seconds || count >= (1u << 24)) {
+                result.objects = count;
+                result.nanoseconds = seconds * 1e9 / count;
+                result.allocations = static_cast<double>(allocations) / count;
+                return result;
+            }
+        }
+    }
+    
+    std::vector<micro_case> get_cases(open_json::data &file, const json &design) {
+        open_json::types::json_object *parent = dynamic_cast<open_json::types::json_object*>(&file);
+        std::vector<micro_case> cases;
+        const json &symbol_body = design["components"]["lib0"]["symbols"][0]["bodies"][0];
+        auto add_shape = [&](const std::string &name, const json &fragment, open_json::types::shapes::shape_type type) {
+            cases.push_back({"shape/" + name, fragment, [&file, parent, type](const json &fragment) -> object_pointer {
+                return open_json::types::shapes::shape::new_shape(type, parent, &file, fragment);
+            }});
+        };
+        for (const json &shape : symbol_body["shapes"]) {
+            std::string type = shape["type"];
+            add_shape(type, shape, open_json::types::shapes::shape_typename_registry[type]);
+        }
+        add_shape("general_polygon", design["pours"][0]["polygons"], open_json::types::shapes::shape_type::GENERAL_POLYGON);
+        add_shape("label", symbol_body["annotations"][0]["label"], open_json::types::shapes::shape_type::LABEL);
+        
+        cases.push_back({"annotation", symbol_body["annotations"][0], [&file, parent](const json &fragment) -> object_pointer {
+            return std::make_shared<open_json::types::annotation>(parent, &file, fragment);
+        }});
+        cases.push_back({"net_point", design["nets"][0]["points"][0], [&file, parent](const json &fragment) -> object_pointer {
+            std::shared_ptr<open_json::types::net_point> point = std::make_shared<open_json::types::net_point>(parent, &file, fragment["point_id"]);
+            point->try_read(fragment);
+            return point;
+        }});
+        std::shared_ptr<open_json::types::component> definition = file.get_components().begin()->second;
+        cases.push_back({"component_instance", design["component_instances"][0], [&file, parent, definition](const json &fragment) -> object_pointer {
+            return std::make_shared<open_json::types::component_instance>(parent, &file, definition, fragment);
+        }});
+        cases.push_back({"pour", design["pours"][0], [&file, parent](const json &fragment) -> object_pointer {
+            return std::make_shared<open_json::types::pour>(parent, &file, fragment);
+        }});
+        cases.push_back({"trace", design["trace_segments"][0], [&file, parent](const json &fragment) -> object_pointer {
+            return std::make_shared<open_json::types::trace>(parent, &file, fragment);
+        }});
+        return cases;
+    }
+    
+    void print_usage() {
+        std::cerr<<"Usage: micro_bench [--min-time=seconds] [--filter=text] [--pour-vertices=N] [--pins-per-net=N] [--output=results.json]"<<std::endl
+                 <<"Reports ns/object and allocations/object for reading and writing single objects of every type."<<std::endl;
+    }
+};
+
+int main(int argc, char **argv) {
+    double min_seconds = 0.2;
+    std::string filter, output_file;
+    open_json::bench::generator_options design_options;
+    design_options.components = 1;
+    design_options.instances = 8;
+    design_options.nets = 4;
+    design_options.traces = 1;
+    design_options.pours = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        size_t separator = argument.find('=');
+        std::string name = argument.substr(2, separator == std::string::npos ? std::string::npos : separator - 2);
+        std::string value = separator == std::string::npos ? "" : argument.substr(separator + 1);
+        if (argument.find("--") != 0 || separator == std::string::npos) {
+            print_usage();
+            return EXIT_FAILURE;
+        } else if (name == "min-time") {
+            try {
+                min_seconds = std::stod(value);
+            } catch (...) {
+                print_usage();
+                return EXIT_FAILURE;
+            }
+        } else if (name == "filter") {
+            filter = value;
+        } else if (name == "output") {
+            output_file = value;
+        } else if ((name != "pour-vertices" && name != "pins-per-net") || !open_json::bench::parse_generator_option(name, value, design_options)) {
+            print_usage();
+            return EXIT_FAILURE;
+        }
+    }
+    // Fragments come from a small generated design, it also holds the instances the net points connect to
+    open_json::library::component_cache::shared().set_capacity(0);
+    json design = open_json::bench::generate_design(design_options);
+    open_json::diagnostic_capture discarded;
+    open_json::diagnostic_capture::scope scope(discarded);
+    open_json::data file("micro", design);
+    
+    json results = {{"min_seconds", min_seconds}, {"cases", json::value_t::object}};
+    std::cerr<<std::left<<std::setw(24)<<"type"<<std::right<<std::setw(14)<<"read ns"<<std::setw(14)<<"read allocs"<<std::setw(14)<<"write ns"<<std::setw(14)<<"write allocs"<<std::endl;
+    for (micro_case &test : get_cases(file, design)) {
+        if (!filter.empty() && test.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        // Objects are kept until the batch is timed so destruction isn't counted
+        std::vector<object_pointer> objects;
+        measurement read = measure(min_seconds, [&](size_t count) {
+            objects.reserve(count);
+            for (size_t i = 0; i < count; i++) {
+                objects.push_back(test.read(test.fragment));
+            }
+        }, [&]() {
+            objects = std::vector<object_pointer>();
+        });
+        object_pointer object = test.read(test.fragment);
+        measurement write = measure(min_seconds, [&](size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                json::object_t rendered = object->get_json();
+            }
+        }, []() {});
+        std::cerr<<std::left<<std::setw(24)<<test.name<<std::right<<std::fixed<<std::setprecision(1)
+                 <<std::setw(14)<<read.nanoseconds<<std::setw(14)<<read.allocations<<std::setw(14)<<write.nanoseconds<<std::setw(14)<<write.allocations<<std::endl;
+        results["cases"][test.name] = {
+            {"fragment_bytes", test.fragment.dump().size()},
+            {"read", {{"objects", read.objects}, {"ns_per_object", read.nanoseconds}, {"allocations_per_object", read.allocations}}},
+            {"get_json", {{"objects", write.objects}, {"ns_per_object", write.nanoseconds}, {"allocations_per_object", write.allocations}}}
+        };
+    }
+    
+    if (output_file.empty()) {
+        std::cout<<std::setw(4)<<results<<std::endl;
+    } else {
+        std::ofstream out(output_file);
+        out<<std::setw(4)<<results<<std::endl;
+        if (!out) {
+            std::cerr<<"Couldn't write the results to "<<output_file<<std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#include <cctype>
+#include <iomanip>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BOUNDS_HAVE_AVX2_KERNEL
+#endif
+
+#include "bounds.hpp"
+#include "parallel.hpp"
+
+namespace {
+    using open_json::types::bounding_box;
+    using open_json::types::point;
+
+    static_assert(sizeof(point) == 2 * sizeof(int64_t), "The SIMD kernels expect points to be packed x, y pairs");
+
+#ifdef BOUNDS_HAVE_AVX2_KERNEL
+    // Each 256 bit register holds two points as x, y, x, y lanes
+    __attribute__((target("avx2")))
+    bounding_box reduce_avx2(const point *points, size_t count) {
+        __m256i minimum[2] = {_mm256_set1_epi64x(std::numeric_limits<int64_t>::max()), _mm256_set1_epi64x(std::numeric_limits<int64_t>::max())};
+        __m256i maximum[2] = {_mm256_set1_epi64x(std::numeric_limits<int64_t>::min()), _mm256_set1_epi64x(std::numeric_limits<int64_t>::min())};
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            for (size_t lane = 0; lane < 2; lane++) {
+                __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(points + i + lane * 2));
+                minimum[lane] = _mm256_blendv_epi8(minimum[lane], values, _mm256_cmpgt_epi64(minimum[lane], values));
+                maximum[lane] = _mm256_blendv_epi8(maximum[lane], values, _mm256_cmpgt_epi64(values, maximum[lane]));
+            }
+        }
+        minimum[0] = _mm256_blendv_epi8(minimum[0], minimum[1], _mm256_cmpgt_epi64(minimum[0], minimum[1]));
+        maximum[0] = _mm256_blendv_epi8(maximum[0], maximum[1], _mm256_cmpgt_epi64(maximum[1], maximum[0]));
+
+        alignas(32) int64_t low[4], high[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(low), minimum[0]);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(high), maximum[0]);
+        bounding_box bounds = open_json::bounds::reduce_scalar(points + i, count - i);
+        bounds.min_x = std::min(bounds.min_x, std::min(low[0], low[2]));
+        bounds.min_y = std::min(bounds.min_y, std::min(low[1], low[3]));
+        bounds.max_x = std::max(bounds.max_x, std::max(high[0], high[2]));
+        bounds.max_y = std::max(bounds.max_y, std::max(high[1], high[3]));
+        return bounds;
+    }
+#endif
+
+    typedef bounding_box (*reduce_function)(const point *points, size_t count);
+
+    reduce_function select_kernel() {
+#ifdef BOUNDS_HAVE_AVX2_KERNEL
+        if (__builtin_cpu_supports("avx2")) {
+            return &reduce_avx2;
+        }
+#endif
+        return &open_json::bounds::reduce_scalar;
+    }
+
+    bool is_outline_layer(std::string layer_name) {
+        std::transform(layer_name.begin(), layer_name.end(), layer_name.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+        return layer_name.find("outline") != std::string::npos;
+    }
+
+    template<typename object_type>
+    void compute_section(const std::vector<std::shared_ptr<object_type>> &objects, std::vector<bounding_box> &object_bounds, open_json::bounds::extents &design_extents) {
+        object_bounds.resize(objects.size());
+        open_json::parallel::for_each_index(objects.size(), [&](size_t index) {
+            object_bounds[index] = objects[index]->get_bounds();
+        });
+        for (size_t index = 0; index < objects.size(); index++) {
+            if (object_bounds[index].is_empty()) {
+                continue;
+            }
+            open_json::bounds::layer_extents &layer = design_extents.layers[objects[index]->get_layer_name()];
+            layer.bounds.expand(object_bounds[index]);
+            layer.object_count++;
+        }
+    }
+};
+
+open_json::types::bounding_box open_json::bounds::reduce_scalar(const types::point *points, size_t count) {
+    types::bounding_box bounds;
+    for (size_t i = 0; i < count; i++) {
+        bounds.expand(points[i]);
+    }
+    return bounds;
+}
+
+open_json::types::bounding_box open_json::bounds::reduce(const types::point *points, size_t count) {
+    static const reduce_function kernel = select_kernel();
+    return kernel(points, count);
+}
+
+std::shared_ptr<open_json::bounds::extents> open_json::bounds::compute_extents(open_json::data &file) {
+    std::shared_ptr<extents> design_extents(new extents());
+    compute_section(file.get_traces(), design_extents->traces, *design_extents);
+    compute_section(file.get_pours(), design_extents->pours, *design_extents);
+    compute_section(file.get_paths(), design_extents->paths, *design_extents);
+    compute_section(file.get_layout_bodies(), design_extents->layout_bodies, *design_extents);
+    compute_section(file.get_pcb_text(), design_extents->pcb_text, *design_extents);
+
+    // Prefer the board outline layer, otherwise fall back to everything placed on the board
+    types::bounding_box everything;
+    for (auto &layer : design_extents->layers) {
+        everything.expand(layer.second.bounds);
+        if (is_outline_layer(layer.first)) {
+            design_extents->board.expand(layer.second.bounds);
+            design_extents->has_outline = true;
+        }
+    }
+    if (!design_extents->has_outline) {
+        design_extents->board = everything;
+    }
+    return design_extents;
+}
+
+void open_json::bounds::print_extents(std::ostream &out, const std::string &name, const extents &design_extents) {
+    auto print_box = [&out](const types::bounding_box &box) {
+        if (box.is_empty()) {
+            out<<"empty";
+            return;
+        }
+        out<<"("<<box.min_x<<", "<<box.min_y<<") - ("<<box.max_x<<", "<<box.max_y<<") "
+           <<std::fixed<<std::setprecision(3)<<(box.max_x - box.min_x) / 1e6<<" x "<<(box.max_y - box.min_y) / 1e6<<" mm";
+        out.unsetf(std::ios_base::floatfield);
+    };
+    out<<"Extents for: "<<name<<std::endl;
+    out<<"  Board"<<(design_extents.has_outline ? " outline" : "")<<": ";
+    print_box(design_extents.board);
+    out<<std::endl;
+    for (auto &layer : design_extents.layers) {
+        out<<"  Layer "<<layer.first<<" ("<<layer.second.object_count<<" objects): ";
+        print_box(layer.second.bounds);
+        out<<std::endl;
+    }
+}
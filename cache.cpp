@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+#include "cache.hpp"
+#include "hash.hpp"
+
+namespace {
+    const std::string entry_extension = ".entry";
+    
+    bool copy_contents(int source, int destination) {
+        char buffer[1 << 16];
+        while (true) {
+            ssize_t count = ::read(source, buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return count == 0;
+            }
+            for (ssize_t written = 0; written < count;) {
+                ssize_t result = ::write(destination, buffer + written, static_cast<size_t>(count - written));
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (result <= 0) {
+                    return false;
+                }
+                written += result;
+            }
+        }
+    }
+    
+    typedef struct entry_info {
+        std::string path;
+        uint64_t size;
+        time_t last_used;
+    } entry_info;
+};
+
+open_json::cache::copy_method open_json::cache::place_file(const std::string &source, const std::string &destination) {
+    int source_file = ::open(source.c_str(), O_RDONLY);
+    if (source_file < 0) {
+        return copy_method::FAILED;
+    }
+    ::unlink(destination.c_str());
+    copy_method method = copy_method::FAILED;
+#ifdef FICLONE
+    int clone = ::open(destination.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (clone >= 0) {
+        if (::ioctl(clone, FICLONE, source_file) == 0) {
+            method = copy_method::REFLINK;
+        }
+        ::close(clone);
+        if (method != copy_method::REFLINK) {
+            ::unlink(destination.c_str());
+        }
+    }
+#endif
+    if (method == copy_method::FAILED) {
+        int copy = ::open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (copy >= 0) {
+            bool copied = copy_contents(source_file, copy);
+            copied = ::close(copy) == 0 && copied;
+            if (copied) {
+                method = copy_method::COPY;
+            } else {
+                ::unlink(destination.c_str());
+            }
+        }
+    }
+    ::close(source_file);
+    return method;
+}
+
+open_json::cache::conversion_cache::conversion_cache(const std::string &cache_directory, uint64_t size_limit) : directory(cache_directory), max_bytes(size_limit), hits(0), misses(0), stores(0), evictions(0), evicted_bytes(0) {
+    if (this->directory.empty()) {
+        return;
+    }
+    if (::mkdir(this->directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr<<"Couldn't create the cache directory "<<this->directory<<": "<<std::strerror(errno)<<", caching disabled"<<std::endl;
+        this->directory.clear();
+    }
+}
+
+std::string open_json::cache::conversion_cache::get_entry_path(const std::string &key) const {
+    return this->directory + "/" + key + entry_extension;
+}
+
+std::string open_json::cache::conversion_cache::make_key(const std::string &input, const converter_options &options, output_type type) {
+    hash::xxhash64 state;
+    state.update(input);
+    // Fixed layout for everything after the input, the length above keeps it from running into the data
+    uint64_t input_length = input.size();
+    state.update(&input_length, sizeof(input_length));
+    state.update(converter_version, std::strlen(converter_version) + 1);
+    state.update(&options.curve_tolerance, sizeof(options.curve_tolerance));
+    int settings[2] = {static_cast<int>(options.output_compression), static_cast<int>(type)};
+    state.update(settings, sizeof(settings));
+    for (const std::string &section : options.only_sections) {
+        state.update(section.c_str(), section.size() + 1);
+    }
+    return hash::to_hex(state.digest());
+}
+
+bool open_json::cache::conversion_cache::lookup(const std::string &key) {
+    if (!this->is_usable()) {
+        return false;
+    }
+    struct stat info;
+    if (::stat(this->get_entry_path(key).c_str(), &info) != 0) {
+        this->misses++;
+        return false;
+    }
+    this->hits++;
+    return true;
+}
+
+bool open_json::cache::conversion_cache::fetch(const std::string &key, const std::string &destination) {
+    if (!this->is_usable()) {
+        return false;
+    }
+    std::string entry = this->get_entry_path(key);
+    if (place_file(entry, destination) == copy_method::FAILED) {
+        return false;
+    }
+    // Marks the entry as recently used
+    ::utimes(entry.c_str(), nullptr);
+    return true;
+}
+
+void open_json::cache::conversion_cache::store(const std::string &key, const std::string &output_file) {
+    if (!this->is_usable()) {
+        return;
+    }
+    // Placed under a temporary name first so other processes never see a partial entry
+    std::string entry = this->get_entry_path(key);
+    std::string temporary = entry + "." + std::to_string(::getpid()) + "." + std::to_string(this->stores.load()) + ".tmp";
+    if (place_file(output_file, temporary) == copy_method::FAILED || ::rename(temporary.c_str(), entry.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return;
+    }
+    ::utimes(entry.c_str(), nullptr);
+    this->stores++;
+    this->evict();
+}
+
+void open_json::cache::conversion_cache::evict() {
+    DIR *listing = ::opendir(this->directory.c_str());
+    if (listing == nullptr) {
+        return;
+    }
+    std::vector<entry_info> entries;
+    uint64_t total = 0;
+    while (dirent *item = ::readdir(listing)) {
+        std::string name(item->d_name);
+        if (name.size() <= entry_extension.size() || name.compare(name.size() - entry_extension.size(), entry_extension.size(), entry_extension) != 0) {
+            continue;
+        }
+        struct stat info;
+        std::string path = this->directory + "/" + name;
+        if (::stat(path.c_str(), &info) == 0) {
+            entries.push_back({path, static_cast<uint64_t>(info.st_size), info.st_mtime});
+            total += static_cast<uint64_t>(info.st_size);
+        }
+    }
+    ::closedir(listing);
+    if (total <= this->max_bytes) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end(), [](const entry_info &a, const entry_info &b) { return a.last_used < b.last_used; });
+    for (const entry_info &entry : entries) {
+        if (total <= this->max_bytes) {
+            break;
+        }
+        if (::unlink(entry.path.c_str()) == 0) {
+            total -= entry.size;
+            this->evictions++;
+            this->evicted_bytes += entry.size;
+        }
+    }
+}
+
+open_json::cache::cache_stats open_json::cache::conversion_cache::get_stats() const {
+    cache_stats stats;
+    stats.hits = this->hits;
+    stats.misses = this->misses;
+    stats.stores = this->stores;
+    stats.evictions = this->evictions;
+    stats.evicted_bytes = this->evicted_bytes;
+    return stats;
+}
+
+void open_json::cache::conversion_cache::print_stats(std::ostream &out) const {
+    cache_stats stats = this->get_stats();
+    size_t lookups = stats.hits + stats.misses;
+    out<<"Conversion cache ("<<this->directory<<"): "<<stats.hits<<" hits, "<<stats.misses<<" misses";
+    if (lookups > 0) {
+        out<<" ("<<(100 * stats.hits / lookups)<<"% hit rate)";
+    }
+    out<<", "<<stats.stores<<" stored, "<<stats.evictions<<" evicted ("<<stats.evicted_bytes<<" bytes)"<<std::endl;
+}
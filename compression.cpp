@@ -0,0 +1,366 @@
+#include <cstring>
+
+#include "compression.hpp"
+
+#ifdef OPEN_JSON_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef OPEN_JSON_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+    const unsigned char gzip_magic[] = {0x1f, 0x8b};
+    const unsigned char zstd_magic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+    std::string unsupported(compression_type type) {
+        return open_json::compression::get_extension(type) + " compressed data isn't supported by this build";
+    }
+};
+
+compression_type open_json::compression::detect(const char *bytes, size_t size) {
+    if (size >= sizeof(gzip_magic) && std::memcmp(bytes, gzip_magic, sizeof(gzip_magic)) == 0) {
+        return compression_type::GZIP;
+    }
+    if (size >= sizeof(zstd_magic) && std::memcmp(bytes, zstd_magic, sizeof(zstd_magic)) == 0) {
+        return compression_type::ZSTD;
+    }
+    return compression_type::NONE;
+}
+
+bool open_json::compression::is_supported(compression_type type) {
+    switch (type) {
+        case compression_type::GZIP:
+#ifdef OPEN_JSON_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case compression_type::ZSTD:
+#ifdef OPEN_JSON_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        case compression_type::NONE:
+        default:
+            return true;
+    }
+}
+
+std::string open_json::compression::get_extension(compression_type type) {
+    switch (type) {
+        case compression_type::GZIP:
+            return ".gz";
+        case compression_type::ZSTD:
+            return ".zst";
+        case compression_type::NONE:
+        default:
+            return "";
+    }
+}
+
+bool open_json::compression::parse_compression_type(const std::string &name, compression_type &type) {
+    if (name == "gzip" || name == "gz") {
+        type = compression_type::GZIP;
+    } else if (name == "zstd" || name == "zst") {
+        type = compression_type::ZSTD;
+    } else if (name == "none") {
+        type = compression_type::NONE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Decompressing Buffer
+const size_t open_json::compression::decompressing_buffer::block_size;
+const size_t open_json::compression::decompressing_buffer::max_blocks;
+
+open_json::compression::decompressing_buffer::decompressing_buffer(std::istream &input) : source(input) {
+    char magic[sizeof(zstd_magic)];
+    input.read(magic, sizeof(magic));
+    this->prefix.assign(magic, static_cast<size_t>(input.gcount()));
+    this->type = detect(this->prefix.data(), this->prefix.size());
+    this->setg(nullptr, nullptr, nullptr);
+    this->worker = std::thread(&decompressing_buffer::decompress, this);
+}
+
+open_json::compression::decompressing_buffer::~decompressing_buffer() {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->cancelled = true;
+    }
+    this->block_taken.notify_all();
+    this->worker.join();
+}
+
+size_t open_json::compression::decompressing_buffer::read_source(char *buffer, size_t size) {
+    size_t count = 0;
+    if (!this->prefix.empty()) {
+        count = std::min(size, this->prefix.size());
+        std::memcpy(buffer, this->prefix.data(), count);
+        this->prefix.erase(0, count);
+    }
+    if (count < size && this->source) {
+        this->source.read(buffer + count, static_cast<std::streamsize>(size - count));
+        count += static_cast<size_t>(this->source.gcount());
+    }
+    return count;
+}
+
+// Waits while max_blocks are queued, returns false if the reader has gone away
+bool open_json::compression::decompressing_buffer::push_block(std::string &block) {
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->block_taken.wait(guard, [this]() { return this->cancelled || this->blocks.size() < max_blocks; });
+    if (this->cancelled) {
+        return false;
+    }
+    this->blocks.push_back(std::move(block));
+    block = std::string();
+    this->block_ready.notify_one();
+    return true;
+}
+
+void open_json::compression::decompressing_buffer::decompress() {
+    std::string error;
+    std::vector<char> input(block_size);
+    std::string block;
+    try {
+        if (!is_supported(this->type)) {
+            error = unsupported(this->type);
+        } else if (this->type == compression_type::NONE) {
+            while (true) {
+                block.resize(block_size);
+                block.resize(this->read_source(&block[0], block.size()));
+                if (block.empty() || !this->push_block(block)) {
+                    break;
+                }
+            }
+        }
+#ifdef OPEN_JSON_HAVE_ZLIB
+        else if (this->type == compression_type::GZIP) {
+            z_stream stream;
+            std::memset(&stream, 0, sizeof(stream));
+            // 32 enables gzip header detection
+            if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                throw std::runtime_error("Couldn't initialize zlib");
+            }
+            bool running = true;
+            int result = Z_OK;
+            while (running) {
+                if (stream.avail_in == 0) {
+                    stream.avail_in = static_cast<uInt>(this->read_source(input.data(), input.size()));
+                    stream.next_in = reinterpret_cast<Bytef*>(input.data());
+                    if (stream.avail_in == 0) {
+                        if (result != Z_STREAM_END) {
+                            error = "Truncated gzip data";
+                        }
+                        break;
+                    }
+                }
+                if (result == Z_STREAM_END) {
+                    // Concatenated gzip members
+                    inflateReset(&stream);
+                }
+                block.resize(block_size);
+                stream.next_out = reinterpret_cast<Bytef*>(&block[0]);
+                stream.avail_out = static_cast<uInt>(block.size());
+                result = inflate(&stream, Z_NO_FLUSH);
+                if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+                    error = std::string("Corrupt gzip data: ") + (stream.msg != nullptr ? stream.msg : "unknown error");
+                    break;
+                }
+                block.resize(block.size() - stream.avail_out);
+                if (!block.empty()) {
+                    running = this->push_block(block);
+                }
+            }
+            inflateEnd(&stream);
+        }
+#endif
+#ifdef OPEN_JSON_HAVE_ZSTD
+        else if (this->type == compression_type::ZSTD) {
+            ZSTD_DStream *stream = ZSTD_createDStream();
+            ZSTD_initDStream(stream);
+            ZSTD_inBuffer in = {input.data(), 0, 0};
+            bool running = true;
+            size_t result = 0;
+            while (running) {
+                if (in.pos == in.size) {
+                    in.size = this->read_source(input.data(), input.size());
+                    in.pos = 0;
+                    if (in.size == 0) {
+                        if (result != 0) {
+                            error = "Truncated zstd data";
+                        }
+                        break;
+                    }
+                }
+                block.resize(block_size);
+                ZSTD_outBuffer out = {&block[0], block.size(), 0};
+                result = ZSTD_decompressStream(stream, &out, &in);
+                if (ZSTD_isError(result)) {
+                    error = std::string("Corrupt zstd data: ") + ZSTD_getErrorName(result);
+                    break;
+                }
+                block.resize(out.pos);
+                if (!block.empty()) {
+                    running = this->push_block(block);
+                }
+            }
+            ZSTD_freeDStream(stream);
+        }
+#endif
+    } catch (std::exception &e) {
+        error = e.what();
+    }
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->finished = true;
+    this->error = error;
+    this->block_ready.notify_all();
+}
+
+std::string open_json::compression::decompressing_buffer::get_error() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->error;
+}
+
+open_json::compression::decompressing_buffer::int_type open_json::compression::decompressing_buffer::underflow() {
+    if (this->gptr() < this->egptr()) {
+        return traits_type::to_int_type(*this->gptr());
+    }
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->block_ready.wait(guard, [this]() { return !this->blocks.empty() || this->finished; });
+    if (this->blocks.empty()) {
+        return traits_type::eof();
+    }
+    this->current = std::move(this->blocks.front());
+    this->blocks.pop_front();
+    this->block_taken.notify_one();
+    this->setg(&this->current[0], &this->current[0], &this->current[0] + this->current.size());
+    return traits_type::to_int_type(*this->gptr());
+}
+
+// Compressing Buffer
+const size_t open_json::compression::compressing_buffer::buffer_size;
+
+open_json::compression::compressing_buffer::compressing_buffer(std::ostream &output_stream, compression_type compression) : sink(output_stream), type(compression), input(buffer_size), output(buffer_size) {
+    if (!is_supported(compression)) {
+        throw std::runtime_error(unsupported(compression));
+    }
+#ifdef OPEN_JSON_HAVE_ZLIB
+    if (compression == compression_type::GZIP) {
+        z_stream *stream = new z_stream();
+        std::memset(stream, 0, sizeof(*stream));
+        // 16 writes a gzip header instead of a zlib one
+        if (deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            delete stream;
+            throw std::runtime_error("Couldn't initialize zlib");
+        }
+        this->state = stream;
+    }
+#endif
+#ifdef OPEN_JSON_HAVE_ZSTD
+    if (compression == compression_type::ZSTD) {
+        ZSTD_CStream *stream = ZSTD_createCStream();
+        ZSTD_initCStream(stream, 3);
+        this->state = stream;
+    }
+#endif
+    this->setp(this->input.data(), this->input.data() + this->input.size());
+}
+
+open_json::compression::compressing_buffer::~compressing_buffer() {
+    try {
+        this->close();
+    } catch (...) {
+    }
+#ifdef OPEN_JSON_HAVE_ZLIB
+    if (this->type == compression_type::GZIP) {
+        deflateEnd(static_cast<z_stream*>(this->state));
+        delete static_cast<z_stream*>(this->state);
+    }
+#endif
+#ifdef OPEN_JSON_HAVE_ZSTD
+    if (this->type == compression_type::ZSTD) {
+        ZSTD_freeCStream(static_cast<ZSTD_CStream*>(this->state));
+    }
+#endif
+}
+
+void open_json::compression::compressing_buffer::compress(bool finish) {
+    size_t pending = static_cast<size_t>(this->pptr() - this->pbase());
+    if (this->type == compression_type::NONE) {
+        // Only the compressors flush differently at the end
+        (void)finish;
+        this->sink.write(this->pbase(), static_cast<std::streamsize>(pending));
+    }
+#ifdef OPEN_JSON_HAVE_ZLIB
+    else if (this->type == compression_type::GZIP) {
+        z_stream *stream = static_cast<z_stream*>(this->state);
+        stream->next_in = reinterpret_cast<Bytef*>(this->pbase());
+        stream->avail_in = static_cast<uInt>(pending);
+        int result;
+        do {
+            stream->next_out = reinterpret_cast<Bytef*>(this->output.data());
+            stream->avail_out = static_cast<uInt>(this->output.size());
+            result = deflate(stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            this->sink.write(this->output.data(), static_cast<std::streamsize>(this->output.size() - stream->avail_out));
+        } while (stream->avail_in > 0 || (finish && result != Z_STREAM_END) || stream->avail_out == 0);
+    }
+#endif
+#ifdef OPEN_JSON_HAVE_ZSTD
+    else if (this->type == compression_type::ZSTD) {
+        ZSTD_CStream *stream = static_cast<ZSTD_CStream*>(this->state);
+        ZSTD_inBuffer in = {this->pbase(), pending, 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out = {this->output.data(), this->output.size(), 0};
+            size_t result = ZSTD_compressStream(stream, &out, &in);
+            if (ZSTD_isError(result)) {
+                throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(result));
+            }
+            this->sink.write(this->output.data(), static_cast<std::streamsize>(out.pos));
+        }
+        for (size_t remaining = finish ? 1 : 0; remaining != 0;) {
+            ZSTD_outBuffer out = {this->output.data(), this->output.size(), 0};
+            remaining = ZSTD_endStream(stream, &out);
+            if (ZSTD_isError(remaining)) {
+                throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining));
+            }
+            this->sink.write(this->output.data(), static_cast<std::streamsize>(out.pos));
+        }
+    }
+#endif
+    this->setp(this->input.data(), this->input.data() + this->input.size());
+    if (!this->sink) {
+        throw std::runtime_error("Couldn't write the compressed output");
+    }
+}
+
+open_json::compression::compressing_buffer::int_type open_json::compression::compressing_buffer::overflow(int_type character) {
+    this->compress(false);
+    if (!traits_type::eq_int_type(character, traits_type::eof())) {
+        *this->pptr() = traits_type::to_char_type(character);
+        this->pbump(1);
+    }
+    return traits_type::not_eof(character);
+}
+
+int open_json::compression::compressing_buffer::sync() {
+    // Compressors keep their own window, a partial block is only pushed through on close
+    if (this->type == compression_type::NONE) {
+        this->compress(false);
+        this->sink.flush();
+    }
+    return 0;
+}
+
+void open_json::compression::compressing_buffer::close() {
+    if (this->closed) {
+        return;
+    }
+    this->closed = true;
+    this->compress(true);
+    this->sink.flush();
+}
@@ -0,0 +1,193 @@
+#include <unordered_set>
+
+#include "connectivity.hpp"
+
+namespace {
+    std::string pin_key(const std::string &instance_id, size_t body_index, size_t action_region_index) {
+        return instance_id + '\0' + std::to_string(body_index) + '\0' + std::to_string(action_region_index);
+    }
+};
+
+// Union Find
+open_json::connectivity::union_find::union_find(size_t size) : parents(size), ranks(size, 0) {
+    for (size_t node = 0; node < size; node++) {
+        this->parents[node] = static_cast<uint32_t>(node);
+    }
+}
+
+uint32_t open_json::connectivity::union_find::find(uint32_t node) {
+    // Path halving
+    while (this->parents[node] != node) {
+        this->parents[node] = this->parents[this->parents[node]];
+        node = this->parents[node];
+    }
+    return node;
+}
+
+bool open_json::connectivity::union_find::unite(uint32_t a, uint32_t b) {
+    a = this->find(a);
+    b = this->find(b);
+    if (a == b) {
+        return false;
+    }
+    if (this->ranks[a] < this->ranks[b]) {
+        std::swap(a, b);
+    }
+    this->parents[b] = a;
+    if (this->ranks[a] == this->ranks[b]) {
+        this->ranks[a]++;
+    }
+    return true;
+}
+
+// Net Graph
+open_json::connectivity::net_graph::net_graph(open_json::data *file, const std::vector<types::net *> &nets) : file_data(file) {
+    for (types::net *net : nets) {
+        this->point_count += net->get_points().size();
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    std::unordered_map<std::string, uint32_t> pin_nodes;
+    uint32_t next_point = 0;
+    this->net_nodes.resize(nets.size());
+    for (size_t net_index = 0; net_index < nets.size(); net_index++) {
+        types::net *net = nets[net_index];
+        net_report report;
+        report.net_id = net->get_id();
+        report.point_count = net->get_points().size();
+        this->net_indices[report.net_id] = net_index;
+        std::vector<uint32_t> &nodes = this->net_nodes[net_index];
+
+        std::unordered_map<std::string, uint32_t> point_nodes;
+        std::unordered_set<uint32_t> net_pins;
+        for (auto &point : net->get_points()) {
+            point_nodes[point.first] = next_point;
+            nodes.push_back(next_point++);
+        }
+
+        size_t first_edge = edges.size();
+        for (auto &point : net->get_points()) {
+            uint32_t node = point_nodes[point.first];
+            for (const types::tracked_string &tracked_id : point.second->get_connected_point_ids()) {
+                std::string id = types::to_string(tracked_id);
+                auto connected = point_nodes.find(id);
+                if (connected == point_nodes.end()) {
+                    report.dangling_point_ids.push_back(id);
+                } else if (connected->second > node) { // Connections are usually listed from both ends
+                    edges.emplace_back(node, connected->second);
+                } else if (connected->second < node) {
+                    edges.emplace_back(connected->second, node);
+                }
+            }
+            for (auto region = point.second->get_begining_of_connected_regions(); region < point.second->get_end_of_connected_regions(); region++) {
+                std::string instance_id = types::to_string(region->component_instance_id);
+                if (this->file_data != nullptr && this->file_data->get_component_instances().find(instance_id) == this->file_data->get_component_instances().end()) {
+                    report.dangling_instance_ids.push_back(instance_id);
+                    continue;
+                }
+                std::string key = pin_key(instance_id, region->body_index, region->action_region_index);
+                auto pin_node = pin_nodes.find(key);
+                if (pin_node == pin_nodes.end()) {
+                    pin_node = pin_nodes.emplace(key, static_cast<uint32_t>(this->point_count + this->pins.size())).first;
+                    pin new_pin;
+                    new_pin.instance_id = instance_id;
+                    new_pin.body_index = region->body_index;
+                    new_pin.action_region_index = region->action_region_index;
+                    this->pins.push_back(new_pin);
+                }
+                if (net_pins.insert(pin_node->second).second) {
+                    nodes.push_back(pin_node->second);
+                    std::vector<size_t> &instance_nets = this->instance_nets[instance_id];
+                    if (instance_nets.empty() || instance_nets.back() != net_index) {
+                        instance_nets.push_back(net_index);
+                    }
+                }
+                edges.emplace_back(node, pin_node->second);
+            }
+        }
+        report.pin_count = nodes.size() - report.point_count;
+
+        // Sub nets only count the net's own edges, a pin shared with another net doesn't join two pieces of this one
+        std::unordered_map<uint32_t, uint32_t> local_nodes;
+        for (uint32_t node : nodes) {
+            local_nodes.emplace(node, static_cast<uint32_t>(local_nodes.size()));
+        }
+        union_find pieces(nodes.size());
+        report.subnet_count = nodes.size();
+        for (size_t edge = first_edge; edge < edges.size(); edge++) {
+            if (pieces.unite(local_nodes[edges[edge].first], local_nodes[edges[edge].second])) {
+                report.subnet_count--;
+            }
+        }
+        this->reports.push_back(report);
+    }
+
+    // Compressed sparse rows, both directions of every edge
+    size_t node_count = this->point_count + this->pins.size();
+    this->offsets.assign(node_count + 1, 0);
+    for (auto &edge : edges) {
+        this->offsets[edge.first + 1]++;
+        this->offsets[edge.second + 1]++;
+    }
+    for (size_t node = 0; node < node_count; node++) {
+        this->offsets[node + 1] += this->offsets[node];
+    }
+    this->targets.resize(edges.size() * 2);
+    std::vector<size_t> fill(this->offsets.begin(), this->offsets.end() - 1);
+    union_find components(node_count);
+    for (auto &edge : edges) {
+        this->targets[fill[edge.first]++] = edge.second;
+        this->targets[fill[edge.second]++] = edge.first;
+        components.unite(edge.first, edge.second);
+    }
+    this->roots.resize(node_count);
+    for (size_t node = 0; node < node_count; node++) {
+        this->roots[node] = components.find(static_cast<uint32_t>(node));
+    }
+}
+
+const open_json::connectivity::net_report *open_json::connectivity::net_graph::get_report(const std::string &net_id) const {
+    auto net = this->net_indices.find(net_id);
+    return net == this->net_indices.end() ? nullptr : &this->reports[net->second];
+}
+
+std::vector<open_json::connectivity::pin> open_json::connectivity::net_graph::get_pins(const std::string &net_id) const {
+    std::vector<pin> net_pins;
+    auto net = this->net_indices.find(net_id);
+    if (net != this->net_indices.end()) {
+        for (uint32_t node : this->net_nodes[net->second]) {
+            if (node >= this->point_count) {
+                net_pins.push_back(this->pins[node - this->point_count]);
+            }
+        }
+    }
+    return net_pins;
+}
+
+std::vector<std::string> open_json::connectivity::net_graph::get_nets_for_instance(const std::string &instance_id) const {
+    std::vector<std::string> nets;
+    auto instance = this->instance_nets.find(instance_id);
+    if (instance != this->instance_nets.end()) {
+        for (size_t net_index : instance->second) {
+            nets.push_back(this->reports[net_index].net_id);
+        }
+    }
+    return nets;
+}
+
+bool open_json::connectivity::net_graph::are_connected(const std::string &net_a, const std::string &net_b) const {
+    auto a = this->net_indices.find(net_a), b = this->net_indices.find(net_b);
+    if (a == this->net_indices.end() || b == this->net_indices.end()) {
+        return false;
+    }
+    std::unordered_set<uint32_t> a_roots;
+    for (uint32_t node : this->net_nodes[a->second]) {
+        a_roots.insert(this->roots[node]);
+    }
+    for (uint32_t node : this->net_nodes[b->second]) {
+        if (a_roots.count(this->roots[node]) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,39 +1,181 @@
 #include <iostream>
 #include <cstdlib>
+#include <fstream>
 #include <iterator>
 
 #include "converter.hpp"
 #include "openjson.hpp"
+#include "accounting.hpp"
+#include "bounds.hpp"
+#include "compression.hpp"
+#include "flatten.hpp"
+#include "instrument.hpp"
+#include "library.hpp"
+#include "pipeline.hpp"
+#include "server.hpp"
 
 int main(int argc, char** argv) {
-    converter convert;
     if (argc < 1) {
         return EXIT_FAILURE;
     }
     // TODO Make more robust!
-    if (convert.openFiles(std::vector<std::string>(argv + 1, argv + argc)))
-        return EXIT_SUCCESS;
-    return EXIT_FAILURE;
+    converter_options options;
+    std::vector<std::string> files;
+    std::string socket_path;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (argument == "--serve" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (argument.find("--compress=") == 0) {
+            if (!open_json::compression::parse_compression_type(argument.substr(argument.find('=') + 1), options.output_compression) || !open_json::compression::is_supported(options.output_compression)) {
+                std::cerr<<"Unsupported output compression: "<<argument<<std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (argument.find("--cache=") == 0) {
+            options.cache_directory = argument.substr(argument.find('=') + 1);
+        } else if (argument.find("--cache-size=") == 0) {
+            try {
+                options.cache_max_bytes = static_cast<uint64_t>(std::stod(argument.substr(argument.find('=') + 1)) * 1024 * 1024);
+            } catch (...) {
+                std::cerr<<"Invalid cache size in MiB: "<<argument<<std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (argument.find("--component-cache=") == 0) {
+            try {
+                options.component_cache_entries = std::stoul(argument.substr(argument.find('=') + 1));
+            } catch (...) {
+                std::cerr<<"Invalid component cache size: "<<argument<<std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (argument.find("--output-type=") == 0) {
+            if (!open_json::server::parse_output_type(argument.substr(argument.find('=') + 1), options.output)) {
+                std::cerr<<"Unknown output type: "<<argument<<std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if ((argument == "--only" && i + 1 < argc) || argument.find("--only=") == 0) {
+            std::string sections = argument == "--only" ? argv[++i] : argument.substr(argument.find('=') + 1);
+            for (const std::string &section : open_json::split(sections, ",")) {
+                if (open_json::find_section_info(section) == nullptr) {
+                    std::cerr<<"Unknown section: "<<section<<std::endl;
+                    return EXIT_FAILURE;
+                }
+                options.only_sections.insert(section);
+            }
+        } else if (argument.find("--trace=") == 0) {
+            options.trace_file = argument.substr(argument.find('=') + 1);
+        } else if (argument == "--mem-report") {
+            options.memory_report = true;
+        } else if (argument == "--stats") {
+            options.print_stats = true;
+        } else if (argument == "--stats=json") {
+            options.print_stats = true;
+            options.stats_as_json = true;
+        } else if (argument == "--flatten-curves") {
+            options.curve_tolerance = open_json::flatten::default_tolerance;
+        } else if (argument.find("--flatten-curves=") == 0) {
+            try {
+                options.curve_tolerance = std::stod(argument.substr(argument.find('=') + 1));
+            } catch (...) {
+                std::cerr<<"Invalid curve tolerance: "<<argument<<std::endl;
+                return EXIT_FAILURE;
+            }
+        } else {
+            files.push_back(argument);
+        }
+    }
+    open_json::library::component_cache::shared().set_capacity(options.component_cache_entries);
+    if (options.memory_report) {
+        // Before anything is read, tracked allocations carry a header from here on
+        open_json::accounting::enable_tracking();
+    }
+    if (!options.trace_file.empty()) {
+        open_json::instrument::set_thread_name("main");
+        open_json::instrument::start_tracing();
+    }
+    bool successful = false;
+    if (files.size() == 1 && files.front() == "-") {
+        // Status messages move to stderr so stdout only carries the converted design
+        std::ios::sync_with_stdio(false);
+        std::ostream output(std::cout.rdbuf());
+        std::streambuf *console = std::cout.rdbuf(std::cerr.rdbuf());
+        successful = converter(options).convertStream(std::cin, output);
+        std::cout.rdbuf(console);
+    } else if (!socket_path.empty()) {
+        open_json::server::conversion_server server(options, socket_path);
+        successful = server.run();
+    } else {
+        converter convert(options);
+        successful = convert.openFiles(files);
+    }
+    if (!options.trace_file.empty()) {
+        std::ofstream trace(options.trace_file);
+        open_json::instrument::write_trace(trace);
+        if (!trace) {
+            std::cerr<<"Couldn't write the trace to "<<options.trace_file<<std::endl;
+        }
+    }
+    return successful ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 converter::converter() {}
 
 bool converter::openFiles(std::vector<std::string> files) {
-    open_json::open_json_format parser;
+    // Designs stream through read, parse and write stages instead of all being held in memory
+    open_json::pipeline::conversion_pipeline pipeline(this->options);
+    // XXX REMOVE AFTER TESTING!
+    bool successful = pipeline.run(files, this->options.output, "_output.upv");
+    if (this->options.print_stats && this->options.stats_as_json) {
+        open_json::instrument::write_json(std::cout);
+    } else if (this->options.print_stats) {
+        pipeline.print_report(std::cout);
+        open_json::instrument::print_table(std::cout);
+    }
+    if (!successful) {
+        return false;
+    }
+    std::cout<<"Sucessfully read the input files!"<<std::endl;
+    std::cout<<"Sucessfully wrote to the output file!"<<std::endl;
+    return true;
+}
+
+bool converter::convertStream(std::istream &input, std::ostream &output) {
+    open_json::open_json_format format(this->options);
+    std::shared_ptr<open_json::data> design;
     try {
-        parser.read(files);
-    } catch (parse_exception e) {
+        open_json::compression::input_stream decompressed(input);
+        design = format.read_file("stdin", decompressed, this->options.output);
+    } catch (std::exception &e) {
         std::cerr<<"Parse Error: "<<e.what()<<std::endl;
         return false;
     }
-    std::cout<<"Sucessfully read the input files!"<<std::endl;
-    // XXX REMOVE AFTER TESTING!
+    std::cout<<"Sucessfully read the input!"<<std::endl;
+    if (this->options.print_stats) {
+        open_json::bounds::print_extents(std::cout, design->original_file_name, *design->get_extents());
+    }
+    if (this->options.memory_report && design->memory_usage) {
+        design->memory_usage->print_report(std::cout);
+    }
     try {
-        parser.write(output_type::ALL, "_output.upv");
-    } catch (std::exception e) {
+        if (this->options.output_compression == compression_type::NONE) {
+            format.write_stream(*design, this->options.output, output);
+        } else {
+            open_json::compression::output_stream compressed(output, this->options.output_compression);
+            format.write_stream(*design, this->options.output, compressed);
+            compressed.close();
+        }
+    } catch (std::exception &e) {
         std::cerr<<"Write Error: "<<e.what()<<std::endl;
         return false;
     }
-    std::cout<<"Sucessfully wrote to the output file!"<<std::endl;
+    if (!output) {
+        std::cerr<<"Write Error: couldn't write to the output stream"<<std::endl;
+        return false;
+    }
+    std::cout<<"Sucessfully wrote the output!"<<std::endl;
+    if (this->options.print_stats && this->options.stats_as_json) {
+        open_json::instrument::write_json(std::cout);
+    } else if (this->options.print_stats) {
+        open_json::instrument::print_table(std::cout);
+    }
     return true;
-}
\ No newline at end of file
+}
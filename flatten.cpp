@@ -0,0 +1,252 @@
+#include <cmath>
+#include <cstring>
+
+#include "flatten.hpp"
+#include "parallel.hpp"
+
+namespace {
+    using open_json::types::point;
+
+    const size_t max_segments = 1 << 16;
+    const int max_subdivision_depth = 16;
+
+    int64_t double_bits(double value) {
+        int64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    point round_point(double x, double y) {
+        return point(static_cast<int64_t>(std::nearbyint(x)), static_cast<int64_t>(std::nearbyint(y)));
+    }
+
+    // Relative to the arc center
+    std::vector<point> tessellate_arc(double radius, double start, double sweep, double tolerance) {
+        const double quarter_turn = open_json::angle_to_radians(0.5);
+        double step = quarter_turn;
+        if (radius > tolerance) {
+            step = std::min(step, 2.0 * std::acos(1.0 - tolerance / radius));
+        }
+        size_t segments = std::min(max_segments, std::max<size_t>(1, static_cast<size_t>(std::ceil(std::abs(sweep) / step))));
+        std::vector<point> points;
+        points.reserve(segments + 1);
+        for (size_t i = 0; i <= segments; i++) {
+            double angle = start + sweep * static_cast<double>(i) / static_cast<double>(segments);
+            points.push_back(round_point(radius * std::cos(angle), radius * std::sin(angle)));
+        }
+        return points;
+    }
+
+    typedef struct vector2 {
+        double x, y;
+    } vector2;
+
+    vector2 midpoint(const vector2 &a, const vector2 &b) {
+        return {(a.x + b.x) / 2.0, (a.y + b.y) / 2.0};
+    }
+
+    double distance_to_chord(const vector2 &p, const vector2 &start, const vector2 &end) {
+        double dx = end.x - start.x, dy = end.y - start.y;
+        double length = std::sqrt(dx * dx + dy * dy);
+        if (length == 0.0) {
+            return std::sqrt((p.x - start.x) * (p.x - start.x) + (p.y - start.y) * (p.y - start.y));
+        }
+        return std::abs((p.x - start.x) * dy - (p.y - start.y) * dx) / length;
+    }
+
+    // Splits in half until both control points are within tolerance of the chord, emits every end point after p0
+    void subdivide_bezier(const vector2 &p0, const vector2 &p1, const vector2 &p2, const vector2 &p3, double tolerance, int depth, std::vector<point> &points) {
+        if (depth >= max_subdivision_depth || std::max(distance_to_chord(p1, p0, p3), distance_to_chord(p2, p0, p3)) <= tolerance) {
+            points.push_back(round_point(p3.x, p3.y));
+            return;
+        }
+        vector2 p01 = midpoint(p0, p1), p12 = midpoint(p1, p2), p23 = midpoint(p2, p3);
+        vector2 p012 = midpoint(p01, p12), p123 = midpoint(p12, p23);
+        vector2 center = midpoint(p012, p123);
+        subdivide_bezier(p0, p01, p012, center, tolerance, depth + 1, points);
+        subdivide_bezier(center, p123, p23, p3, tolerance, depth + 1, points);
+    }
+
+    open_json::flatten::polyline translate(const open_json::flatten::polyline &relative, const point &origin) {
+        std::shared_ptr<std::vector<point>> points(new std::vector<point>(*relative));
+        for (point &p : *points) {
+            p.x += origin.x;
+            p.y += origin.y;
+        }
+        return points;
+    }
+
+    typedef struct curve_reference {
+        json *shapes;
+        size_t index;
+    } curve_reference;
+
+    bool is_curve(const json &shape) {
+        if (!shape.is_object() || shape.find("type") == shape.end() || !shape["type"].is_string()) {
+            return false;
+        }
+        std::string type_name = shape["type"];
+        return type_name == "arc" || type_name == "bezier";
+    }
+
+    void collect_curves(json &value, std::vector<curve_reference> &curves) {
+        if (value.is_object()) {
+            for (json::iterator it = value.begin(); it != value.end(); it++) {
+                if (it.key() == "shapes" && it.value().is_array()) {
+                    for (size_t index = 0; index < it.value().size(); index++) {
+                        if (is_curve(it.value()[index])) {
+                            curves.push_back({&it.value(), index});
+                        }
+                    }
+                }
+                collect_curves(it.value(), curves);
+            }
+        } else if (value.is_array()) {
+            for (json &element : value) {
+                collect_curves(element, curves);
+            }
+        }
+    }
+
+    json::array_t curve_to_lines(const json &curve, double tolerance) {
+        json::array_t lines;
+        std::shared_ptr<open_json::types::shapes::shape> shape = open_json::types::shapes::shape::new_shape(open_json::types::shapes::shape_typename_registry.find(curve["type"])->second, nullptr, nullptr, curve);
+        open_json::flatten::polyline points = open_json::flatten::flatten(*shape, tolerance);
+        for (size_t i = 1; points && i < points->size(); i++) {
+            lines.push_back({
+                {"flip", open_json::get_value_or_default(curve, "flip", false)},
+                {"rotation", open_json::get_value_or_default(curve, "rotation", 0.0f)},
+                {"styles", curve.find("styles") != curve.end() ? curve["styles"] : json(json::value_t::object)},
+                {"type", "line"},
+                {"width", open_json::get_value_or_default(curve, "width", 0u)},
+                {"p1", {{"x", (*points)[i - 1].x}, {"y", (*points)[i - 1].y}}},
+                {"p2", {{"x", (*points)[i].x}, {"y", (*points)[i].y}}}
+            });
+        }
+        return lines;
+    }
+};
+
+// Tessellation Cache
+const size_t open_json::flatten::tessellation_cache::shard_count;
+const size_t open_json::flatten::tessellation_cache::max_entries_per_shard;
+
+bool open_json::flatten::tessellation_cache::key::operator==(const key &other) const {
+    return this->type == other.type && std::equal(std::begin(this->values), std::end(this->values), std::begin(other.values));
+}
+
+size_t open_json::flatten::tessellation_cache::key_hash::operator()(const key &k) const {
+    uint64_t hash = 14695981039346656037ULL ^ static_cast<uint64_t>(k.type);
+    for (int64_t value : k.values) {
+        hash = (hash ^ static_cast<uint64_t>(value)) * 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    return static_cast<size_t>(hash);
+}
+
+open_json::flatten::polyline open_json::flatten::tessellation_cache::lookup(const key &curve_key, std::function<std::vector<types::point>()> tessellate) {
+    shard &bucket = this->shards[key_hash()(curve_key) % shard_count];
+    {
+        std::lock_guard<std::mutex> lock(bucket.lock);
+        auto entry = bucket.entries.find(curve_key);
+        if (entry != bucket.entries.end()) {
+            this->hits++;
+            return entry->second;
+        }
+    }
+    // Tessellate outside of the lock, racing threads produce identical results
+    this->misses++;
+    polyline points(new std::vector<types::point>(tessellate()));
+    std::lock_guard<std::mutex> lock(bucket.lock);
+    if (bucket.entries.size() >= max_entries_per_shard) {
+        bucket.entries.clear();
+    }
+    bucket.entries[curve_key] = points;
+    return points;
+}
+
+open_json::flatten::polyline open_json::flatten::tessellation_cache::get_arc(types::shapes::arc &shape, double tolerance) {
+    double radius = shape.get_radius(), start = shape.get_start_radians(), sweep = shape.get_sweep_radians();
+    key curve_key = {types::shapes::shape_type::ARC, {shape.get_radius(), double_bits(start), double_bits(sweep), double_bits(tolerance), 0, 0, 0}};
+    return translate(this->lookup(curve_key, [=]() { return tessellate_arc(radius, start, sweep, tolerance); }), shape.get_position());
+}
+
+open_json::flatten::polyline open_json::flatten::tessellation_cache::get_bezier(types::shapes::bezier_curve &shape, double tolerance) {
+    std::vector<types::point> control_points;
+    shape.get_vertices(control_points);
+    types::point origin = control_points[0];
+    for (types::point &p : control_points) {
+        p.x -= origin.x;
+        p.y -= origin.y;
+    }
+    key curve_key = {types::shapes::shape_type::BEZIER_CURVE, {control_points[1].x, control_points[1].y, control_points[2].x, control_points[2].y, control_points[3].x, control_points[3].y, double_bits(tolerance)}};
+    return translate(this->lookup(curve_key, [&control_points, tolerance]() {
+        std::vector<vector2> p;
+        for (types::point &control_point : control_points) {
+            p.push_back({static_cast<double>(control_point.x), static_cast<double>(control_point.y)});
+        }
+        std::vector<types::point> points(1, types::point());
+        subdivide_bezier(p[0], p[1], p[2], p[3], tolerance, 0, points);
+        return points;
+    }), origin);
+}
+
+void open_json::flatten::tessellation_cache::clear() {
+    for (shard &bucket : this->shards) {
+        std::lock_guard<std::mutex> lock(bucket.lock);
+        bucket.entries.clear();
+    }
+}
+
+open_json::flatten::tessellation_cache &open_json::flatten::tessellation_cache::shared() {
+    static tessellation_cache cache;
+    return cache;
+}
+
+// Flattening
+open_json::flatten::polyline open_json::flatten::flatten(types::shapes::shape &shape, double tolerance) {
+    switch (shape.type) {
+        case types::shapes::shape_type::ARC:
+            return tessellation_cache::shared().get_arc(dynamic_cast<types::shapes::arc &>(shape), tolerance);
+        case types::shapes::shape_type::BEZIER_CURVE:
+            return tessellation_cache::shared().get_bezier(dynamic_cast<types::shapes::bezier_curve &>(shape), tolerance);
+        default:
+            return polyline();
+    }
+}
+
+std::vector<open_json::flatten::polyline> open_json::flatten::flatten(const std::vector<std::shared_ptr<types::shapes::shape>> &shapes, double tolerance) {
+    std::vector<polyline> polylines(shapes.size());
+    open_json::parallel::for_each_index(shapes.size(), [&](size_t index) {
+        if (shapes[index]) {
+            polylines[index] = flatten(*shapes[index], tolerance);
+        }
+    });
+    return polylines;
+}
+
+void open_json::flatten::normalize(json &document, double tolerance) {
+    std::vector<curve_reference> curves;
+    collect_curves(document, curves);
+    std::vector<json::array_t> replacements(curves.size());
+    open_json::parallel::for_each_index(curves.size(), [&](size_t index) {
+        replacements[index] = curve_to_lines((*curves[index].shapes)[curves[index].index], tolerance);
+    });
+
+    // Curves of the same array were collected next to each other and in order
+    for (size_t first = 0; first < curves.size();) {
+        json *shapes = curves[first].shapes;
+        json::array_t normalized;
+        size_t next = first;
+        for (size_t index = 0; index < shapes->size(); index++) {
+            if (next < curves.size() && curves[next].shapes == shapes && curves[next].index == index) {
+                normalized.insert(normalized.end(), replacements[next].begin(), replacements[next].end());
+                next++;
+            } else {
+                normalized.push_back((*shapes)[index]);
+            }
+        }
+        *shapes = normalized;
+        first = next;
+    }
+}
@@ -0,0 +1,132 @@
+#include <cstring>
+
+#include "hash.hpp"
+
+namespace {
+    const uint64_t prime1 = 11400714785074694791ULL;
+    const uint64_t prime2 = 14029467366897019727ULL;
+    const uint64_t prime3 = 1609587929392839161ULL;
+    const uint64_t prime4 = 9650029242287828579ULL;
+    const uint64_t prime5 = 2870177450012600261ULL;
+    
+    inline uint64_t rotate_left(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+    
+    // Little endian loads, memcpy keeps unaligned reads legal
+    inline uint64_t read64(const unsigned char *bytes) {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+    
+    inline uint32_t read32(const unsigned char *bytes) {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+    
+    inline uint64_t round(uint64_t accumulator, uint64_t input) {
+        accumulator += input * prime2;
+        accumulator = rotate_left(accumulator, 31);
+        return accumulator * prime1;
+    }
+    
+    inline uint64_t merge_round(uint64_t hash, uint64_t accumulator) {
+        hash ^= round(0, accumulator);
+        return hash * prime1 + prime4;
+    }
+};
+
+open_json::hash::xxhash64::xxhash64(uint64_t hash_seed) : seed(hash_seed) {
+    this->reset();
+}
+
+void open_json::hash::xxhash64::reset() {
+    this->accumulators[0] = this->seed + prime1 + prime2;
+    this->accumulators[1] = this->seed + prime2;
+    this->accumulators[2] = this->seed;
+    this->accumulators[3] = this->seed - prime1;
+    this->total_length = 0;
+    this->buffered = 0;
+}
+
+void open_json::hash::xxhash64::update(const void *data, size_t length) {
+    const unsigned char *input = static_cast<const unsigned char*>(data);
+    const unsigned char *end = input + length;
+    this->total_length += length;
+    
+    if (this->buffered + length < sizeof(this->buffer)) {
+        std::memcpy(this->buffer + this->buffered, input, length);
+        this->buffered += length;
+        return;
+    }
+    if (this->buffered > 0) {
+        size_t fill = sizeof(this->buffer) - this->buffered;
+        std::memcpy(this->buffer + this->buffered, input, fill);
+        for (int lane = 0; lane < 4; lane++) {
+            this->accumulators[lane] = round(this->accumulators[lane], read64(this->buffer + lane * 8));
+        }
+        input += fill;
+        this->buffered = 0;
+    }
+    for (; input + 32 <= end; input += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            this->accumulators[lane] = round(this->accumulators[lane], read64(input + lane * 8));
+        }
+    }
+    this->buffered = static_cast<size_t>(end - input);
+    std::memcpy(this->buffer, input, this->buffered);
+}
+
+uint64_t open_json::hash::xxhash64::digest() const {
+    uint64_t hash;
+    if (this->total_length >= 32) {
+        hash = rotate_left(this->accumulators[0], 1) + rotate_left(this->accumulators[1], 7) + rotate_left(this->accumulators[2], 12) + rotate_left(this->accumulators[3], 18);
+        for (int lane = 0; lane < 4; lane++) {
+            hash = merge_round(hash, this->accumulators[lane]);
+        }
+    } else {
+        hash = this->seed + prime5;
+    }
+    hash += this->total_length;
+    
+    const unsigned char *input = this->buffer, *end = this->buffer + this->buffered;
+    for (; input + 8 <= end; input += 8) {
+        hash ^= round(0, read64(input));
+        hash = rotate_left(hash, 27) * prime1 + prime4;
+    }
+    if (input + 4 <= end) {
+        hash ^= static_cast<uint64_t>(read32(input)) * prime1;
+        hash = rotate_left(hash, 23) * prime2 + prime3;
+        input += 4;
+    }
+    for (; input < end; input++) {
+        hash ^= (*input) * prime5;
+        hash = rotate_left(hash, 11) * prime1;
+    }
+    
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t open_json::hash::xxhash64_of(const void *data, size_t length, uint64_t seed) {
+    xxhash64 state(seed);
+    state.update(data, length);
+    return state.digest();
+}
+
+std::string open_json::hash::to_hex(uint64_t digest) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        text[i] = digits[digest & 0xf];
+        digest >>= 4;
+    }
+    return text;
+}
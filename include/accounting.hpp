@@ -0,0 +1,104 @@
+#ifndef __ACCOUNTING__
+#define __ACCOUNTING__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <ostream>
+#include <string>
+
+namespace open_json {
+    namespace accounting {
+        enum class kind {
+            OBJECTS,    // Parsed types, one count per object
+            VERTICES,   // Point lists of shapes, pours, paths and traces
+            ATTRIBUTES, // Attribute and style maps, including the inline part of their strings
+            STRINGS     // Heap payloads of tracked strings: ids, names, layer names and attribute text
+        };
+        const size_t kind_count = 4;
+        
+        // Live bytes and objects charged to one section of one design. Every tracked allocation holds a reference, so an
+        // account outlives its owner for as long as anything charged to it is alive (shared components for example).
+        class account {
+        private:
+            std::string name;
+            std::atomic<size_t> references;
+            std::atomic<int64_t> bytes[kind_count];
+            std::atomic<int64_t> objects, peak_bytes;
+            
+            explicit account(const std::string &account_name);
+        public:
+            static account *create(const std::string &name);
+            const std::string &get_name() const { return this->name; }
+            void retain() { this->references.fetch_add(1, std::memory_order_relaxed); }
+            void release();
+            void add(kind type, int64_t byte_count, int64_t object_count);
+            int64_t get_bytes(kind type) const { return this->bytes[static_cast<size_t>(type)].load(std::memory_order_relaxed); }
+            int64_t get_total_bytes() const;
+            int64_t get_objects() const { return this->objects.load(std::memory_order_relaxed); }
+            int64_t get_peak_bytes() const { return this->peak_bytes.load(std::memory_order_relaxed); }
+        };
+        
+        // Tracking is switched on once before the first design is read and stays on, it adds a header to tracked allocations
+        void enable_tracking();
+        bool is_tracking();
+        
+        // Allocations on the calling thread are charged to the active account, none is active outside section reads
+        account *current_account();
+        class account_scope {
+        private:
+            account *previous;
+        public:
+            explicit account_scope(account *active);
+            account_scope(const account_scope &) = delete;
+            account_scope &operator=(const account_scope &) = delete;
+            ~account_scope();
+        };
+        
+        void *allocate(size_t size, kind type, int64_t objects);
+        void deallocate(void *memory);
+        
+        // Stateless, the account an allocation was charged to is kept in front of it
+        template<typename element_type, kind type>
+        class tracking_allocator {
+        public:
+            typedef element_type value_type;
+            template<typename other_type>
+            struct rebind {
+                typedef tracking_allocator<other_type, type> other;
+            };
+            
+            tracking_allocator() {}
+            template<typename other_type>
+            tracking_allocator(const tracking_allocator<other_type, type> &) {}
+            element_type *allocate(size_t count) { return static_cast<element_type*>(accounting::allocate(count * sizeof(element_type), type, 0)); }
+            void deallocate(element_type *memory, size_t) { accounting::deallocate(memory); }
+            template<typename other_type>
+            bool operator==(const tracking_allocator<other_type, type> &) const { return true; }
+            template<typename other_type>
+            bool operator!=(const tracking_allocator<other_type, type> &) const { return false; }
+        };
+        
+        // Only payloads too long for the small string buffer are allocated, and so charged
+        typedef std::basic_string<char, std::char_traits<char>, tracking_allocator<char, kind::STRINGS>> string;
+        
+        // The accounts of one design, one per section
+        class design_usage {
+        private:
+            std::string design_name;
+            std::map<std::string, account*> accounts;
+        public:
+            explicit design_usage(const std::string &name) : design_name(name) {}
+            design_usage(const design_usage &) = delete;
+            design_usage &operator=(const design_usage &) = delete;
+            ~design_usage();
+            // Created on first use
+            account *get_account(const std::string &section);
+            void print_report(std::ostream &out) const;
+        };
+    };
+};
+
+#endif /* defined(__ACCOUNTING__) */
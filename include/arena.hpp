@@ -0,0 +1,57 @@
+#ifndef __ARENA__
+#define __ARENA__
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "accounting.hpp"
+
+namespace open_json {
+    namespace arena {
+        // Fixed capacity block of objects of one type. Objects are constructed in place and destroyed together with the arena,
+        // hand them out through aliasing shared_ptrs that own the arena to keep a single allocation per block.
+        // The block is charged to the active memory account, objects are counted as they are constructed.
+        template<typename object_type>
+        class object_arena {
+        private:
+            object_type *storage;
+            size_t capacity, count;
+            accounting::account *owner;
+        public:
+            explicit object_arena(size_t size) : storage(static_cast<object_type*>(accounting::allocate(size * sizeof(object_type), accounting::kind::OBJECTS, 0))), capacity(size), count(0),
+                owner(accounting::is_tracking() ? accounting::current_account() : nullptr) {
+                if (this->owner != nullptr) {
+                    this->owner->retain();
+                }
+            }
+            object_arena(const object_arena &) = delete;
+            object_arena &operator=(const object_arena &) = delete;
+            ~object_arena() {
+                if (this->owner != nullptr) {
+                    this->owner->add(accounting::kind::OBJECTS, 0, -static_cast<int64_t>(this->count));
+                    this->owner->release();
+                }
+                while (this->count > 0) {
+                    this->storage[--this->count].~object_type();
+                }
+                accounting::deallocate(this->storage);
+            }
+            size_t size() const { return this->count; }
+            template<typename... argument_types>
+            object_type *emplace(argument_types&&... arguments) {
+                if (this->count == this->capacity) {
+                    throw std::bad_alloc();
+                }
+                object_type *object = new (this->storage + this->count) object_type(std::forward<argument_types>(arguments)...);
+                this->count++;
+                if (this->owner != nullptr) {
+                    this->owner->add(accounting::kind::OBJECTS, 0, 1);
+                }
+                return object;
+            }
+        };
+    };
+};
+
+#endif /* defined(__ARENA__) */
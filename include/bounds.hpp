@@ -0,0 +1,37 @@
+#ifndef __BOUNDS__
+#define __BOUNDS__
+
+#include <string>
+#include <map>
+#include <vector>
+#include <ostream>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace bounds {
+        // Min/max reduction over a vertex array, uses AVX2 when the cpu supports it
+        types::bounding_box reduce(const types::point *points, size_t count);
+        inline types::bounding_box reduce(const std::vector<types::point> &points) { return reduce(points.data(), points.size()); }
+        inline types::bounding_box reduce(const types::point_list &points) { return reduce(points.data(), points.size()); }
+        types::bounding_box reduce_scalar(const types::point *points, size_t count);
+
+        typedef struct layer_extents {
+            types::bounding_box bounds;
+            size_t object_count = 0;
+        } layer_extents;
+
+        // Per object bounds are stored in the same order as the matching open_json::data vectors
+        typedef struct extents {
+            types::bounding_box board;
+            bool has_outline = false;
+            std::map<std::string, layer_extents> layers;
+            std::vector<types::bounding_box> traces, pours, paths, layout_bodies, pcb_text;
+        } extents;
+
+        std::shared_ptr<extents> compute_extents(open_json::data &file);
+        void print_extents(std::ostream &out, const std::string &name, const extents &design_extents);
+    };
+};
+
+#endif /* defined(__BOUNDS__) */
@@ -0,0 +1,56 @@
+#ifndef __CACHE__
+#define __CACHE__
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "converter.hpp"
+
+namespace open_json {
+    namespace cache {
+        typedef struct cache_stats {
+            size_t hits = 0, misses = 0, stores = 0, evictions = 0;
+            uint64_t evicted_bytes = 0;
+        } cache_stats;
+        
+        // How a file was placed, cheapest first
+        enum class copy_method {
+            REFLINK,
+            COPY,
+            FAILED
+        };
+        
+        // Copy on write clone where the file system supports it, otherwise a plain copy. Never a hard link, the destination
+        // could then be rewritten in place and change the source with it.
+        copy_method place_file(const std::string &source, const std::string &destination);
+        
+        // On disk cache of converted outputs keyed by xxHash64 of the input bytes, the converter version and every option
+        // that changes the output. Entries are files named after their key, the modification time records the last use
+        // and the least recently used entries are removed once the cache grows past its size limit.
+        class conversion_cache {
+        private:
+            std::string directory;
+            uint64_t max_bytes;
+            std::atomic<size_t> hits, misses, stores, evictions;
+            std::atomic<uint64_t> evicted_bytes;
+            
+            std::string get_entry_path(const std::string &key) const;
+            void evict();
+        public:
+            conversion_cache(const std::string &cache_directory, uint64_t size_limit);
+            bool is_usable() const { return !this->directory.empty(); }
+            static std::string make_key(const std::string &input, const converter_options &options, output_type type);
+            // Counted as a hit or a miss
+            bool lookup(const std::string &key);
+            // Places the cached output at destination, false if the entry was evicted since the lookup
+            bool fetch(const std::string &key, const std::string &destination);
+            void store(const std::string &key, const std::string &output_file);
+            cache_stats get_stats() const;
+            void print_stats(std::ostream &out) const;
+        };
+    };
+};
+
+#endif /* defined(__CACHE__) */
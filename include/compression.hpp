@@ -0,0 +1,105 @@
+#ifndef __COMPRESSION__
+#define __COMPRESSION__
+
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "converter.hpp"
+
+namespace open_json {
+    namespace compression {
+        // From the magic bytes at the start of a stream, anything unknown is treated as uncompressed
+        compression_type detect(const char *bytes, size_t size);
+        // gzip support needs zlib and zstd support libzstd at build time, the Makefile finds them
+        bool is_supported(compression_type type);
+        std::string get_extension(compression_type type);
+        bool parse_compression_type(const std::string &name, compression_type &type);
+
+        // Decompresses on its own thread a few blocks ahead of the reader, only those blocks are ever held in memory.
+        // Uncompressed data is passed through. Corrupt data ends the stream early and leaves the reason in get_error,
+        // the JSON lexer is noexcept so nothing may be thrown through it.
+        class decompressing_buffer : public std::streambuf {
+        private:
+            static const size_t block_size = 1 << 18;
+            static const size_t max_blocks = 4;
+
+            std::istream &source;
+            compression_type type;
+            std::string prefix; // Bytes read for detection, handed to the decompressor first
+            std::thread worker;
+            std::mutex lock;
+            std::condition_variable block_ready, block_taken;
+            std::deque<std::string> blocks;
+            std::string current;
+            bool finished = false, cancelled = false;
+            std::string error;
+
+            size_t read_source(char *buffer, size_t size);
+            bool push_block(std::string &block);
+            void decompress();
+        protected:
+            int_type underflow() override;
+        public:
+            explicit decompressing_buffer(std::istream &input);
+            ~decompressing_buffer();
+            compression_type get_type() const { return this->type; }
+            std::string get_error();
+        };
+
+        class input_stream : public std::istream {
+        private:
+            decompressing_buffer buffer;
+        public:
+            explicit input_stream(std::istream &input) : std::istream(nullptr), buffer(input) {
+                this->rdbuf(&this->buffer);
+            }
+            compression_type get_type() const { return this->buffer.get_type(); }
+            std::string get_error() { return this->buffer.get_error(); }
+        };
+
+        // Compresses on the writing thread, close() finishes the compressed stream and reports errors
+        class compressing_buffer : public std::streambuf {
+        private:
+            static const size_t buffer_size = 1 << 18;
+
+            std::ostream &sink;
+            compression_type type;
+            std::vector<char> input, output;
+            void *state = nullptr;
+            bool closed = false;
+
+            void compress(bool finish);
+        protected:
+            int_type overflow(int_type character) override;
+            int sync() override;
+        public:
+            compressing_buffer(std::ostream &output_stream, compression_type compression);
+            ~compressing_buffer();
+            void close();
+        };
+
+        class output_stream : public std::ostream {
+        private:
+            compressing_buffer buffer;
+        public:
+            output_stream(std::ostream &output, compression_type type) : std::ostream(nullptr), buffer(output, type) {
+                this->rdbuf(&this->buffer);
+                this->exceptions(std::ios::badbit);
+            }
+            void close() {
+                this->flush();
+                this->buffer.close();
+            }
+        };
+    };
+};
+
+#endif /* defined(__COMPRESSION__) */
@@ -0,0 +1,64 @@
+#ifndef __CONNECTIVITY__
+#define __CONNECTIVITY__
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace connectivity {
+        typedef struct pin {
+            std::string instance_id;
+            size_t body_index = 0, action_region_index = 0;
+        } pin;
+
+        typedef struct net_report {
+            std::string net_id;
+            size_t point_count = 0, pin_count = 0;
+            size_t subnet_count = 0; // Pieces the net falls apart into through its own points and pins
+            std::vector<std::string> dangling_point_ids; // Connected point ids that aren't points of the net
+            std::vector<std::string> dangling_instance_ids; // Action regions on instances that don't exist
+            bool is_consistent() const { return this->dangling_point_ids.empty() && this->dangling_instance_ids.empty(); }
+        } net_report;
+
+        class union_find {
+        private:
+            std::vector<uint32_t> parents;
+            std::vector<uint8_t> ranks;
+        public:
+            explicit union_find(size_t size);
+            uint32_t find(uint32_t node);
+            bool unite(uint32_t a, uint32_t b);
+        };
+
+        // Net points and action regions (pins) are the nodes, connected points and connected action regions the edges.
+        // Adjacency is stored in compressed sparse row form, pins shared between nets join them together.
+        class net_graph {
+        private:
+            open_json::data *file_data;
+            std::vector<size_t> offsets;
+            std::vector<uint32_t> targets;
+            std::vector<uint32_t> roots;
+            std::vector<pin> pins; // Pin nodes are numbered after every point node
+            size_t point_count = 0;
+            std::vector<net_report> reports;
+            std::vector<std::vector<uint32_t>> net_nodes;
+            std::unordered_map<std::string, size_t> net_indices;
+            std::unordered_map<std::string, std::vector<size_t>> instance_nets;
+        public:
+            net_graph(open_json::data *file, const std::vector<types::net *> &nets);
+            size_t get_number_of_nodes() const { return this->roots.size(); }
+            size_t get_number_of_edges() const { return this->targets.size() / 2; }
+            const std::vector<net_report> &get_reports() const { return this->reports; }
+            const net_report *get_report(const std::string &net_id) const;
+            std::vector<pin> get_pins(const std::string &net_id) const;
+            std::vector<std::string> get_nets_for_instance(const std::string &instance_id) const;
+            // True when the nets share a pin, directly or through other nets
+            bool are_connected(const std::string &net_a, const std::string &net_b) const;
+        };
+    };
+};
+
+#endif /* defined(__CONNECTIVITY__) */
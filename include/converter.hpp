@@ -1,10 +1,17 @@
 #ifndef __CONVERTER__
 #define __CONVERTER__
 
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <set>
 #include <string>
 #include <vector>
 #include <stdexcept>
 
+// Part of every conversion cache key, bump it whenever a change alters the converted output
+const char *const converter_version = "0.2.0-eda-converter-1";
+
 enum class eda_type {
     OPEN_JSON,
     EAGLE,
@@ -18,10 +25,35 @@ enum class output_type {
     ALL
 };
 
+enum class compression_type {
+    NONE,
+    GZIP,
+    ZSTD
+};
+
+typedef struct converter_options {
+    bool print_stats = false;
+    bool stats_as_json = false; // --stats=json prints the phase timings as JSON instead of tables
+    std::string trace_file; // Chrome trace event timeline of the run, empty disables tracing
+    bool memory_report = false; // Live bytes per section of every design after reading it
+    double curve_tolerance = 0.0; // Chord error used to flatten arcs and beziers on output, 0 keeps them as curves
+    compression_type output_compression = compression_type::NONE; // Input compression is detected from the data
+    std::string cache_directory; // Conversion cache, empty disables it
+    uint64_t cache_max_bytes = 1ULL << 30;
+    size_t component_cache_entries = 4096; // Component definitions shared between designs, 0 disables sharing
+    output_type output = output_type::ALL;
+    std::set<std::string> only_sections; // Top level sections kept on input along with those they depend on, empty keeps all
+} converter_options;
+
 class converter {
+private:
+    converter_options options;
 public:
     converter();
+    converter(converter_options converter_settings) : options(converter_settings) {}
     bool openFiles(std::vector<std::string> files);
+    // Converts one design, converter - reads it from stdin and writes it to stdout
+    bool convertStream(std::istream &input, std::ostream &output);
     bool write(eda_type type);
 };
 
@@ -0,0 +1,61 @@
+#ifndef __FLATTEN__
+#define __FLATTEN__
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace flatten {
+        typedef std::shared_ptr<const std::vector<types::point>> polyline;
+
+        // Polylines are cached relative to the curve origin (arc center, bezier start) so identical curves anywhere share an entry
+        class tessellation_cache {
+            typedef struct key {
+                types::shapes::shape_type type;
+                int64_t values[7];
+                bool operator==(const key &other) const;
+            } key;
+
+            struct key_hash {
+                size_t operator()(const key &k) const;
+            };
+
+            typedef struct shard {
+                std::mutex lock;
+                std::unordered_map<key, polyline, key_hash> entries;
+            } shard;
+        private:
+            static const size_t shard_count = 16;
+            shard shards[shard_count];
+            std::atomic<size_t> hits, misses;
+            polyline lookup(const key &curve_key, std::function<std::vector<types::point>()> tessellate);
+        public:
+            // Each shard is emptied when it grows past this many entries
+            static const size_t max_entries_per_shard = 1 << 14;
+
+            tessellation_cache() : hits(0), misses(0) {}
+            polyline get_arc(types::shapes::arc &shape, double tolerance);
+            polyline get_bezier(types::shapes::bezier_curve &shape, double tolerance);
+            size_t get_hits() { return this->hits; }
+            size_t get_misses() { return this->misses; }
+            void clear();
+            static tessellation_cache &shared();
+        };
+
+        // Maximum distance in nanometres between a curve and its chords
+        static const double default_tolerance = 1000.0;
+
+        // Returns nullptr for shapes that are not arcs or bezier curves
+        polyline flatten(types::shapes::shape &shape, double tolerance = default_tolerance);
+        std::vector<polyline> flatten(const std::vector<std::shared_ptr<types::shapes::shape>> &shapes, double tolerance = default_tolerance);
+
+        // Output normalization, replaces every arc and bezier in the "shapes" arrays of a document with line segments
+        void normalize(json &document, double tolerance = default_tolerance);
+    };
+};
+
+#endif /* defined(__FLATTEN__) */
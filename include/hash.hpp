@@ -0,0 +1,33 @@
+#ifndef __HASH__
+#define __HASH__
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace open_json {
+    namespace hash {
+        // Streaming xxHash64, gives the same digests as the reference implementation
+        class xxhash64 {
+        private:
+            uint64_t accumulators[4];
+            uint64_t seed, total_length;
+            unsigned char buffer[32];
+            size_t buffered;
+        public:
+            explicit xxhash64(uint64_t hash_seed = 0);
+            void reset();
+            void update(const void *data, size_t length);
+            void update(const std::string &text) { this->update(text.data(), text.size()); }
+            // Doesn't change the state, more data may be added afterwards
+            uint64_t digest() const;
+        };
+        
+        uint64_t xxhash64_of(const void *data, size_t length, uint64_t seed = 0);
+        inline uint64_t xxhash64_of(const std::string &text, uint64_t seed = 0) { return xxhash64_of(text.data(), text.size(), seed); }
+        // Zero padded, 16 lowercase hex digits
+        std::string to_hex(uint64_t digest);
+    };
+};
+
+#endif /* defined(__HASH__) */
@@ -0,0 +1,77 @@
+#ifndef __INSTRUMENT__
+#define __INSTRUMENT__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace open_json {
+    namespace instrument {
+        typedef std::chrono::steady_clock clock_type;
+        
+        inline uint64_t nanoseconds_since(clock_type::time_point start) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count());
+        }
+        
+        // Totals of one phase for the whole process. Time is summed over every thread, so phases that run in parallel
+        // can add up to more than the wall clock time. The amount is a free counter, bytes or objects depending on the phase.
+        class metric {
+        private:
+            std::string name;
+            std::atomic<uint64_t> calls, nanoseconds, amount;
+        public:
+            explicit metric(const std::string &metric_name) : name(metric_name), calls(0), nanoseconds(0), amount(0) {}
+            const std::string &get_name() const { return this->name; }
+            void add_time(uint64_t elapsed, uint64_t call_count = 1) {
+                this->calls.fetch_add(call_count, std::memory_order_relaxed);
+                this->nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+            }
+            void add(uint64_t value) { this->amount.fetch_add(value, std::memory_order_relaxed); }
+            uint64_t get_calls() const { return this->calls.load(std::memory_order_relaxed); }
+            uint64_t get_nanoseconds() const { return this->nanoseconds.load(std::memory_order_relaxed); }
+            uint64_t get_amount() const { return this->amount.load(std::memory_order_relaxed); }
+            void reset();
+        };
+        
+        // The same name always gives the same metric and metrics are never freed, hot paths keep the reference in a static
+        metric &get_metric(const std::string &name);
+        
+        // Set by start_tracing, while it is off timers only update their metric
+        extern std::atomic<bool> tracing;
+        void start_tracing();
+        // Spans are kept per thread and only locked by their own thread, the name shows up as the track name in the viewer
+        void set_thread_name(const std::string &name);
+        void record_span(const metric &timed, clock_type::time_point start, uint64_t duration, const std::string &detail = std::string());
+        // Chrome trace event JSON, loads in chrome://tracing and Perfetto
+        void write_trace(std::ostream &out);
+        
+        // Also a span on the thread's timeline while tracing, the detail (a file or net name) is shown with it
+        class scoped_timer {
+        private:
+            metric &target;
+            const std::string *detail;
+            clock_type::time_point start;
+        public:
+            explicit scoped_timer(metric &timed, const std::string *span_detail = nullptr) : target(timed), detail(span_detail), start(clock_type::now()) {}
+            scoped_timer(metric &timed, const std::string &span_detail) : scoped_timer(timed, &span_detail) {}
+            scoped_timer(const scoped_timer &) = delete;
+            scoped_timer &operator=(const scoped_timer &) = delete;
+            ~scoped_timer() {
+                uint64_t elapsed = nanoseconds_since(this->start);
+                this->target.add_time(elapsed);
+                if (tracing.load(std::memory_order_relaxed)) {
+                    record_span(this->target, this->start, elapsed, this->detail != nullptr ? *this->detail : std::string());
+                }
+            }
+        };
+        
+        void reset();
+        // Metrics that were never used are left out, both are sorted by name
+        void print_table(std::ostream &out);
+        void write_json(std::ostream &out);
+    };
+};
+
+#endif /* defined(__INSTRUMENT__) */
@@ -0,0 +1,58 @@
+#ifndef __LIBRARY__
+#define __LIBRARY__
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace library {
+        // 128 bits from two differently seeded xxHash64 runs over the component subtree
+        typedef struct component_key {
+            uint64_t low = 0, high = 0;
+            bool operator==(const component_key &other) const { return this->low == other.low && this->high == other.high; }
+        } component_key;
+        
+        typedef struct component_key_hash {
+            size_t operator()(const component_key &key) const { return static_cast<size_t>(key.low); }
+        } component_key_hash;
+        
+        // Library id, legacy 0.1.x layout and the JSON subtree decide how a component is read, they make up the key
+        component_key make_key(const std::string &library_id, bool legacy_format, const json &component_json);
+        
+        // Components shared between every design read by the process, the same part in many designs is read once and
+        // the designs hold the same immutable definition. The parent and file pointers of a shared component refer to the
+        // design that first read it, they are only followed while reading. Bounded by entry count, least recently used first out.
+        class component_cache {
+            typedef struct entry {
+                std::shared_ptr<types::component> component;
+                diagnostic_capture::entry_list diagnostics; // Written again on every hit so the console output doesn't change
+                std::list<component_key>::iterator position;
+            } entry;
+        private:
+            std::mutex lock;
+            size_t capacity;
+            std::list<component_key> recently_used; // Most recent first
+            std::unordered_map<component_key, entry, component_key_hash> entries;
+            size_t hits = 0, misses = 0, evictions = 0;
+        public:
+            explicit component_cache(size_t max_entries) : capacity(max_entries) {}
+            // 0 turns the cache off
+            void set_capacity(size_t max_entries);
+            // Returns the cached definition or calls read and keeps the result, errors thrown by read are never cached
+            std::shared_ptr<types::component> get(const std::string &library_id, bool legacy_format, const json &component_json, const std::function<std::shared_ptr<types::component>()> &read);
+            size_t get_size();
+            void print_stats(std::ostream &out);
+            static component_cache &shared();
+        };
+    };
+};
+
+#endif /* defined(__LIBRARY__) */
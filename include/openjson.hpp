@@ -1,14 +1,24 @@
+#ifndef __OPENJSON__
+#define __OPENJSON__
+
 #include <string>
 #include <regex>
 #include <map>
+#include <set>
 #include <unordered_map>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <atomic>
 #include <locale>
 #include <functional>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <sstream>
 
 #include "json.hpp"
+#include "accounting.hpp"
 #include "converter.hpp"
 
 using json = nlohmann::json;
@@ -17,6 +27,26 @@ namespace open_json {
     // Forward declare data
     class data;
     
+    namespace spatial {
+        class spatial_index;
+    };
+    
+    namespace bounds {
+        struct extents;
+    };
+    
+    namespace transform {
+        struct world_geometry;
+    };
+    
+    namespace connectivity {
+        class net_graph;
+    };
+    
+    namespace scan {
+        class structural_index;
+    };
+    
     inline std::vector<std::string> split(const std::string &input, const std::string &regex) {
         // passing -1 as the submatch index parameter performs splitting
         std::regex re(regex);
@@ -59,24 +89,153 @@ namespace open_json {
         return return_value;
     }
     
+    // OpenJSON stores angles (rotations, arc angles) in units of pi radians
+    inline double angle_to_radians(double angle) {
+        return angle * 3.14159265358979323846;
+    }
+    
+    // Collects the status messages and errors written while it is active so work done in parallel can report them in input order
+    class diagnostic_capture {
+    public:
+        typedef std::vector<std::pair<bool, std::string>> entry_list; // (is error, text)
+    private:
+        class capture_buffer : public std::stringbuf {
+        private:
+            entry_list &entries;
+            bool is_error;
+        protected:
+            int sync() override;
+        public:
+            capture_buffer(entry_list &entry_storage, bool error) : entries(entry_storage), is_error(error) {}
+        };
+    private:
+        entry_list entries;
+        capture_buffer message_buffer, error_buffer;
+    public:
+        std::ostream messages, errors;
+        
+        // Activates a capture on the calling thread until the scope ends
+        class scope {
+        private:
+            diagnostic_capture *previous;
+        public:
+            explicit scope(diagnostic_capture &capture);
+            ~scope();
+        };
+        
+        diagnostic_capture() : message_buffer(entries, false), error_buffer(entries, true), messages(&message_buffer), errors(&error_buffer) {}
+        // Writes everything captured to the streams of the calling thread in the order it was written
+        void replay();
+        // Everything captured so far as one string, messages and errors interleaved
+        std::string get_text();
+        // Everything captured so far, for writing out more than once
+        entry_list get_entries();
+        static void write_entries(const entry_list &entries);
+    };
+    
+    // std::cout and std::cerr unless a diagnostic_capture is active on the calling thread
+    std::ostream &message_stream();
+    std::ostream &error_stream();
+    
+    // Top level sections, which outputs need them and which sections they are decoded from. Shared by the section filter
+    // on input and the writers.
+    typedef struct section_info {
+        std::string key;
+        bool schematic, layout;
+        std::vector<std::string> dependencies;
+    } section_info;
+    
+    const std::vector<section_info> &get_section_table();
+    const section_info *find_section_info(const std::string &key);
+    // Sections selected by the output type and only_sections (empty selects all) plus everything they depend on.
+    // The version and design info are always needed, keys missing from the table only when nothing is filtered.
+    bool is_section_needed(const std::string &key, output_type type, const std::set<std::string> &only_sections);
+    // Parser callback that skips the values of the top level keys keep_section rejects without building them, null
+    // when keep_section is. One callback serves a single parse.
+    json::parser_callback_t get_section_callback(std::function<bool(const std::string &)> keep_section);
+    
     namespace types {
-        inline void populate_attributes(std::map<std::string, std::string> &attribute_map, json json_data) {
+        // Charged to the section being read when memory accounting is on, see accounting.hpp
+        typedef std::map<std::string, std::string, std::less<std::string>, accounting::tracking_allocator<std::pair<const std::string, std::string>, accounting::kind::ATTRIBUTES>> attribute_map;
+        
+        inline void populate_attributes(attribute_map &attributes, json json_data) {
             for (json::iterator it = json_data.begin(); it != json_data.end(); it++) {
-                attribute_map[it.key()] = it.value();
+                attributes[it.key()] = it.value();
             }
         }
         
         typedef struct point {
             int64_t x, y;
             point() : point(0, 0) {}
-            point(int x_pos, int y_pos) : x(x_pos), y(y_pos) {}
+            point(int64_t x_pos, int64_t y_pos) : x(x_pos), y(y_pos) {}
         } point;
         
+        typedef std::vector<point, accounting::tracking_allocator<point, accounting::kind::VERTICES>> point_list;
+        
+        // Ids, names and layer names, the bulk of the text in nets and instances
+        typedef accounting::string tracked_string;
+        inline std::string to_string(const tracked_string &text) { return std::string(text.data(), text.size()); }
+        inline tracked_string to_tracked(const std::string &text) { return tracked_string(text.data(), text.size()); }
+        // Built in place, a std::string in between would be one more copy per id written
+        inline json to_json(const tracked_string &text) {
+            json value(json::value_t::string);
+            value.get_ref<std::string&>().assign(text.data(), text.size());
+            return value;
+        }
+        inline json to_json(const std::vector<tracked_string> &texts) {
+            json values(json::value_t::array);
+            for (const tracked_string &text : texts) {
+                values.push_back(to_json(text));
+            }
+            return values;
+        }
+        
+        // Axis aligned box in the same nanometre units as point, default constructed boxes are empty
+        typedef struct bounding_box {
+            int64_t min_x, min_y, max_x, max_y;
+            bounding_box() : min_x(std::numeric_limits<int64_t>::max()), min_y(std::numeric_limits<int64_t>::max()), max_x(std::numeric_limits<int64_t>::min()), max_y(std::numeric_limits<int64_t>::min()) {}
+            bounding_box(int64_t x1, int64_t y1, int64_t x2, int64_t y2) : min_x(std::min(x1, x2)), min_y(std::min(y1, y2)), max_x(std::max(x1, x2)), max_y(std::max(y1, y2)) {}
+            bool is_empty() const { return this->min_x > this->max_x || this->min_y > this->max_y; }
+            void expand(const point &p) {
+                this->min_x = std::min(this->min_x, p.x);
+                this->min_y = std::min(this->min_y, p.y);
+                this->max_x = std::max(this->max_x, p.x);
+                this->max_y = std::max(this->max_y, p.y);
+            }
+            void expand(const bounding_box &other) {
+                if (other.is_empty()) {
+                    return;
+                }
+                this->min_x = std::min(this->min_x, other.min_x);
+                this->min_y = std::min(this->min_y, other.min_y);
+                this->max_x = std::max(this->max_x, other.max_x);
+                this->max_y = std::max(this->max_y, other.max_y);
+            }
+            void inflate(int64_t amount) {
+                if (this->is_empty()) {
+                    return;
+                }
+                this->min_x -= amount;
+                this->min_y -= amount;
+                this->max_x += amount;
+                this->max_y += amount;
+            }
+            bool intersects(const bounding_box &other) const {
+                return !this->is_empty() && !other.is_empty() && this->min_x <= other.max_x && other.min_x <= this->max_x && this->min_y <= other.max_y && other.min_y <= this->max_y;
+            }
+            bool contains(const point &p) const { return p.x >= this->min_x && p.x <= this->max_x && p.y >= this->min_y && p.y <= this->max_y; }
+        } bounding_box;
+        
         class json_object {
         protected:
             json_object *parent;
         public:
             json_object(json_object *super) : parent(super) {}
+            // Every parsed object is charged to the section being read when memory accounting is on
+            static void *operator new(size_t size) { return accounting::allocate(size, accounting::kind::OBJECTS, 1); }
+            static void operator delete(void *memory) { accounting::deallocate(memory); }
+            static void *operator new(size_t, void *where) { return where; }
+            static void operator delete(void *, void *) {}
             virtual void read(json json_data) = 0;
             virtual json::object_t get_json() = 0;
         };
@@ -98,13 +257,17 @@ namespace open_json {
                 open_json::data *file_data;
             public:
                 shape_type type;
-                std::map<std::string, std::string> styles;
+                attribute_map styles;
                 float rotation = 0.0f;
                 bool flip = false;
             public:
                 shape (json_object *super, open_json::data *file, json json_data, shape_type shape_type) : json_object(super), file_data(file), type(shape_type) { this->read(json_data); }
                 virtual void read(json json_data) override;
                 virtual json::object_t get_json() override;
+                // Bounds in the coordinate space the shape was defined in, shape rotation and flip are not applied
+                virtual bounding_box get_bounds() { return bounding_box(); }
+                // The points that position the shape, in definition order. Lengths such as radii and widths are unaffected by placement
+                virtual void get_vertices(std::vector<point> &) {}
                 static std::shared_ptr<shape> new_shape(shape_type type, json_object *super, open_json::data *file, json json_data) {
                     if (shape_registry.find(type) == shape_registry.end()) {
                         return nullptr;
@@ -123,6 +286,8 @@ namespace open_json {
                 rectangle(json_object *super, open_json::data *file, json json_data) : rectangle(super, file, json_data, shape_type::RECTANGLE) {}
                 virtual void read(json json_data) override;
                 virtual json::object_t get_json() override;
+                virtual bounding_box get_bounds() override;
+                virtual void get_vertices(std::vector<point> &vertices) override;
             };
             
             class rounded_rectangle : public rectangle {
@@ -141,8 +306,16 @@ namespace open_json {
                 point position;
             public:
                 arc(json_object *super, open_json::data *file, json json_data) : shape(super, file, json_data, shape_type::ARC) { this->read(json_data); }
+                point get_position() { return this->position; }
+                int get_radius() { return this->radius; }
+                unsigned int get_width() { return this->width; }
+                double get_start_radians() { return open_json::angle_to_radians(this->start_angle); }
+                // Signed sweep from the start angle, positive is counter clockwise. Equal start and end angles are a full circle
+                double get_sweep_radians();
                 void read(json json_data) override;
                 json::object_t get_json() override;
+                bounding_box get_bounds() override;
+                void get_vertices(std::vector<point> &vertices) override { vertices.push_back(this->position); }
             };
             
             class circle : public shape {
@@ -153,6 +326,8 @@ namespace open_json {
                 circle(json_object *super, open_json::data *file, json json_data) : shape(super, file, json_data, shape_type::CIRCLE) { this->read(json_data); }
                 void read(json json_data) override;
                 json::object_t get_json() override;
+                bounding_box get_bounds() override;
+                void get_vertices(std::vector<point> &vertices) override { vertices.push_back(this->position); }
             };
                             
             class label : public shape {
@@ -177,9 +352,12 @@ namespace open_json {
                 std::string get_text() { return this->text; }
                 void read(json json_data) override;
                 json::object_t get_json() override;
+                bounding_box get_bounds() override;
+                void get_vertices(std::vector<point> &vertices) override { vertices.push_back(this->position); }
             };
             
             class line : public shape {
+            protected:
                 unsigned int width = 0;
                 point start, end;
             protected:
@@ -188,6 +366,8 @@ namespace open_json {
                 line(json_object *super, open_json::data *file, json json_data) : line(super, file, json_data, shape_type::LINE) { }
                 virtual void read(json json_data) override;
                 virtual json::object_t get_json() override;
+                virtual bounding_box get_bounds() override;
+                virtual void get_vertices(std::vector<point> &vertices) override { vertices.push_back(this->start); vertices.push_back(this->end); }
             };
             
             class rounded_segment : public line {
@@ -196,11 +376,12 @@ namespace open_json {
                 rounded_segment(json_object *super, open_json::data *file, json json_data) : line(super, file, json_data, shape_type::ROUNDED_SEGMENT) { this->read(json_data); }
                 void read(json json_data) override;
                 json::object_t get_json() override;
+                bounding_box get_bounds() override;
             };
             
             class polygon : public shape {
                 unsigned int line_width = 0;
-                std::vector<point> points;
+                point_list points;
                 std::vector<shape_type> shape_types;
             protected:
                 polygon(json_object *super, open_json::data *file, json json_data, shape_type type) : shape(super, file, json_data, type) { this->read(json_data); }
@@ -208,6 +389,8 @@ namespace open_json {
                 polygon(json_object *super, open_json::data *file, json json_data) : polygon(super, file, json_data, shape_type::POLYGON) { }
                 virtual void read(json json_data) override;
                 virtual json::object_t get_json() override;
+                virtual bounding_box get_bounds() override;
+                virtual void get_vertices(std::vector<point> &vertices) override { vertices.insert(vertices.end(), this->points.begin(), this->points.end()); }
             };
             
             class bezier_curve : public shape {
@@ -216,11 +399,13 @@ namespace open_json {
                 bezier_curve(json_object *super, open_json::data *file, json json_data) : shape(super, file, json_data, shape_type::BEZIER_CURVE) { this->read(json_data); }
                 void read(json json_data) override;
                 json::object_t get_json() override;
+                bounding_box get_bounds() override;
+                void get_vertices(std::vector<point> &vertices) override;
             };
             
             class general_polygon : public polygon {
                 typedef struct {
-                    std::vector<point> points;
+                    point_list points;
                 } polygon_points;
                 
                 std::vector<polygon_points> holes;
@@ -229,6 +414,9 @@ namespace open_json {
                 general_polygon(json_object *super, open_json::data *file, json json_data) : polygon(super, file, json_data, shape_type::GENERAL_POLYGON) { this->read(json_data); }
                 void read(json json_data) override;
                 json::object_t get_json() override;
+                bounding_box get_bounds() override;
+                // Polygon points, then the outline, then each hole
+                void get_vertices(std::vector<point> &vertices) override;
             };
             
             class general_polygon_set : public polygon {
@@ -237,6 +425,9 @@ namespace open_json {
                 general_polygon_set(json_object *super, open_json::data *file, json json_data) : polygon(super, file, json_data, shape_type::GENERAL_POLYGON_SET) { this->read(json_data); }
                 void read(json json_data) override;
                 json::object_t get_json() override;
+                bounding_box get_bounds() override;
+                // Polygon points, then the vertices of each sub shape
+                void get_vertices(std::vector<point> &vertices) override;
             };
             
             // Factory
@@ -268,6 +459,9 @@ namespace open_json {
             std::vector<std::shared_ptr<annotation>> annotations;
         public:
             symbol_attribute(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
+            point get_position() { return this->position; }
+            float get_rotation() { return this->rotation; }
+            bool get_flip() { return this->flip; }
             void read(json json_data) override;
             json::object_t get_json() override;
         };
@@ -278,7 +472,7 @@ namespace open_json {
             float rotation = 0.0f;
             point position;
             bool flip = false;
-            std::string layer_name;
+            tracked_string layer_name;
         public:
             footprint_attribute(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file){ this->read(json_data); }
             void read(json json_data) override;
@@ -288,15 +482,15 @@ namespace open_json {
         class action_region : public json_object {
         private:
             open_json::data *file_data;
-            std::map<std::string, std::string> attributes;
-            std::map<std::string, std::string> styles;
+            attribute_map attributes;
+            attribute_map styles;
             std::vector<std::vector<int>> connections;
-            std::string name;
+            tracked_string name;
             point p1, p2;
-            std::string ref_id;
+            tracked_string ref_id;
         public:
             action_region(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
-            std::string get_ref_id() { return this->ref_id; }
+            std::string get_ref_id() { return to_string(this->ref_id); }
             void read(json json_data) override;
             json::object_t get_json() override;
         };
@@ -307,14 +501,20 @@ namespace open_json {
             float rotation = 0.0f;
             std::vector<int> connections;
             bool flip = false, moveable = true, removeable = true;
-            std::string layer_name;
+            tracked_string layer_name;
             std::vector<std::shared_ptr<shapes::shape>> shapes;
             std::vector<std::shared_ptr<action_region>> action_regions;
             std::vector<std::shared_ptr<annotation>> annotations;
-            std::map<std::string, std::string> styles;
+            attribute_map styles;
         public:
             body(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
             void add_shape(std::shared_ptr<shapes::shape> shape) { this->shapes.push_back(shape); }
+            std::string get_layer_name() { return to_string(this->layer_name); }
+            bounding_box get_bounds();
+            float get_rotation() { return this->rotation; }
+            bool get_flip() { return this->flip; }
+            size_t get_number_of_shapes() { return this->shapes.size(); }
+            std::shared_ptr<shapes::shape> get_shape_at_index(size_t index) { return index < this->shapes.size() ? this->shapes[index] : std::shared_ptr<shapes::shape>(); }
             size_t get_number_of_action_regions() { return this->action_regions.size(); }
             std::shared_ptr<types::action_region> get_action_region_at_index(size_t index) { return index < this->action_regions.size() ? this->action_regions[index] : std::shared_ptr<types::action_region>(); }
             void read(json json_data) override;
@@ -325,8 +525,8 @@ namespace open_json {
         class generated_object_attribute : public json_object {
         protected:
             open_json::data *file_data;
-            std::map<std::string, std::string> attributes;
-            std::string layer_name;
+            attribute_map attributes;
+            tracked_string layer_name;
             bool flip = false;
             float rotation = 0.0f;
             point position;
@@ -363,6 +563,8 @@ namespace open_json {
             std::vector<std::shared_ptr<generated_object>> generated_objects;
         public:
             footprint(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
+            size_t get_number_of_bodies() { return this->bodies.size(); }
+            std::shared_ptr<types::body> get_body_at_index(size_t index) { return index < this->bodies.size() ? this->bodies[index] : std::shared_ptr<types::body>(); }
             void read(json json_data) override;
             json::object_t get_json() override;
         };
@@ -370,17 +572,21 @@ namespace open_json {
         class component : public json_object {
         private:
             open_json::data *file_data;
-            std::string library_id, name;
-            std::map<std::string, std::string> attributes;
+            tracked_string library_id, name;
+            attribute_map attributes;
             std::vector<footprint> footprints;
             std::vector<std::shared_ptr<symbol>> symbols;
         public:
-            component(json_object *super, open_json::data *file, json json_data, std::string id) : json_object(super), file_data(file), library_id(id){ this->read(json_data); }
-            std::string get_library_id() { return this->library_id; }
+            component(json_object *super, open_json::data *file, json json_data, std::string id) : json_object(super), file_data(file), library_id(to_tracked(id)) { this->read(json_data); }
+            std::string get_library_id() { return to_string(this->library_id); }
             size_t get_number_of_symbols() { return this->symbols.size(); }
+            size_t get_number_of_footprints() { return this->footprints.size(); }
+            types::footprint *get_footprint_at_index(size_t index) { return index < this->footprints.size() ? &this->footprints[index] : nullptr; }
             std::shared_ptr<types::symbol> get_symbol_at_index(size_t index) { return index < this->symbols.size() ? this->symbols[index] : std::shared_ptr<types::symbol>(); }
             void read(json json_data) override;
-            json::object_t get_json() override;
+            json::object_t get_json() override { return this->get_json(output_type::ALL); }
+            // Schematic output leaves out the footprints, layout output the symbols
+            json::object_t get_json(output_type type);
         };
         
         class component_instance : public json_object {
@@ -393,43 +599,53 @@ namespace open_json {
         private:
             open_json::data *file_data;
             std::shared_ptr<component> component_def;
-            std::map<std::string, std::string> attributes;
+            attribute_map attributes;
             std::vector<symbol_attribute> symbol_attributes;
             std::vector<footprint_attribute> footprint_attributes;
             std::vector<generated_object_attribute> generated_object_attributes;
-            std::string instance_id;
+            tracked_string instance_id;
             footprint_pos_data footprint_pos;
             size_t symbol_index = 0, footprint_index = 0;
         public:
             component_instance(json_object *super, open_json::data *file, std::shared_ptr<component> def, json json_data) : json_object(super), file_data(file), component_def(def) { read(json_data); }
-            std::string get_id() { return instance_id; }
+            std::string get_id() { return to_string(this->instance_id); }
             size_t get_symbol_index() { return this->symbol_index; }
+            size_t get_footprint_index() { return this->footprint_index; }
+            point get_footprint_position() { return this->footprint_pos.position; }
+            float get_footprint_rotation() { return this->footprint_pos.rotation; }
+            // Flipped footprints and footprints placed on the bottom side are mirrored
+            bool is_footprint_mirrored() { return this->footprint_pos.flip || this->footprint_pos.side == "bottom"; }
+            size_t get_number_of_symbol_attributes() { return this->symbol_attributes.size(); }
+            types::symbol_attribute *get_symbol_attribute_at_index(size_t index) { return index < this->symbol_attributes.size() ? &this->symbol_attributes[index] : nullptr; }
             std::shared_ptr<types::component> get_definition() { return this->component_def; }
             void read(json json_data) override;
-            json::object_t get_json() override;
+            json::object_t get_json() override { return this->get_json(output_type::ALL); }
+            // Schematic output leaves out the footprint placement and attributes, layout output the symbol ones
+            json::object_t get_json(output_type type);
         };
         
         class net_point : public json_object {
            typedef struct connected_action_region {
                 size_t action_region_index;
                 size_t body_index;
-                std::string component_instance_id;
+                tracked_string component_instance_id;
                 int order_index = 0;
-                std::string signal_name;
+                tracked_string signal_name;
                 connected_action_region(size_t action_region, size_t body, std::string component_instance, int order, std::string signal) :
-                    action_region_index(action_region), body_index(body), component_instance_id(component_instance), order_index(order), signal_name(signal) {}
+                    action_region_index(action_region), body_index(body), component_instance_id(to_tracked(component_instance)), order_index(order), signal_name(to_tracked(signal)) {}
             } connected_action_region;
         private:
             open_json::data *file_data;
-            std::string point_id;
+            tracked_string point_id;
             std::vector<connected_action_region> connected_action_regions;
-            std::vector<std::string> connected_point_ids;
+            std::vector<tracked_string> connected_point_ids;
             point position;
         public:
-            net_point(json_object *super, open_json::data *file, std::string id) : json_object(super), file_data(file), point_id(id) { }
+            net_point(json_object *super, open_json::data *file, std::string id) : json_object(super), file_data(file), point_id(to_tracked(id)) { }
+            std::string get_id() { return to_string(this->point_id); }
             std::vector<connected_action_region>::iterator get_begining_of_connected_regions() { return this->connected_action_regions.begin(); }
             std::vector<connected_action_region>::iterator get_end_of_connected_regions() { return this->connected_action_regions.end(); }
-            std::vector<std::string> get_connected_point_ids() { return this->connected_point_ids; }
+            const std::vector<tracked_string> &get_connected_point_ids() { return this->connected_point_ids; }
             bool try_read(json json_data);  
             virtual void read(json json_data) override { try_read(json_data); }
             json::object_t get_json() override;
@@ -443,14 +659,15 @@ namespace open_json {
         private:
             open_json::data *file_data;
             std::vector<std::shared_ptr<annotation>> annotations;
-            std::map<std::string, std::string> attributes;
-            std::string net_id;
+            attribute_map attributes;
+            tracked_string net_id;
             type net_type = type::NETS;
             std::map<std::string, std::shared_ptr<net_point>> points;
-            std::vector<std::string> signals;
+            std::vector<tracked_string> signals;
         public:
             net(json_object *super, open_json::data *file) : json_object(super), file_data(file) { }
-            std::string get_id() { return net_id; }
+            std::string get_id() { return to_string(this->net_id); }
+            const std::map<std::string, std::shared_ptr<net_point>> &get_points() { return this->points; }
             bool try_read(json json_data);  
             virtual void read(json json_data) override { try_read(json_data); }
             json::object_t get_json() override;
@@ -462,12 +679,14 @@ namespace open_json {
             };
         private:
             open_json::data *file_data;
-            std::string layer_name;
+            tracked_string layer_name;
             point start, end;
-            std::vector<point> control_points;
+            point_list control_points;
             type trace_type = type::STRAIGHT;
             double width;
         public:
+            std::string get_layer_name() { return to_string(this->layer_name); }
+            bounding_box get_bounds();
             trace(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
             void read(json json_data) override;
             json::object_t get_json() override;
@@ -476,14 +695,16 @@ namespace open_json {
         class pour : public json_object {
         private:
             open_json::data *file_data;
-            std::string attached_net_id;
-            std::map<std::string, std::string> attributes;
-            std::string layer_name;
+            tracked_string attached_net_id;
+            attribute_map attributes;
+            tracked_string layer_name;
             int order_index = 0;
-            std::vector<point> points;
+            point_list points;
             std::shared_ptr<shapes::shape> pour_shape;
             std::vector<shapes::shape_type> shape_types;
         public:
+            std::string get_layer_name() { return to_string(this->layer_name); }
+            bounding_box get_bounds();
             pour(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
             void read(json json_data) override;
             json::object_t get_json() override;
@@ -494,10 +715,12 @@ namespace open_json {
             open_json::data *file_data;
             bool flip = false, visible = true;
             std::shared_ptr<shapes::label> label;
-            std::string layer_name;
+            tracked_string layer_name;
             float rotation = 0.0f;
             point position;
         public:
+            std::string get_layer_name() { return to_string(this->layer_name); }
+            bounding_box get_bounds();
             pcb_text(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
             void read(json json_data) override;
             json::object_t get_json() override;
@@ -508,7 +731,7 @@ namespace open_json {
         protected:
             open_json::data *file_data;
             bool flip = false;
-            std::string layer_name;
+            tracked_string layer_name;
             float rotation = 0.0f;
             point position;
         public:
@@ -518,7 +741,7 @@ namespace open_json {
         };
         
         class layout_object : public layout_body_attribute {
-            std::map<std::string, std::string> attributes;
+            attribute_map attributes;
             std::vector<int> connections;
         public:
             layout_object(json_object *super, open_json::data *file, json json_data) : layout_body_attribute(super, file, json_data) { this->read(json_data); }
@@ -529,7 +752,7 @@ namespace open_json {
         class layer_option : public json_object {
         private:
             open_json::data *file_data;
-            std::string ident, name;
+            tracked_string ident, name;
             bool is_copper = true;
         public:
             layer_option(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
@@ -540,13 +763,15 @@ namespace open_json {
         class path : public json_object {
         private:
             open_json::data *file_data;
-            std::map<std::string, std::string> attributes;
+            attribute_map attributes;
             bool is_closed = true;
-            std::string layer_name;
+            tracked_string layer_name;
             double width = 250000.0; // .25mm
-            std::vector<point> points;
+            point_list points;
             std::vector<shapes::shape_type> shape_types;
         public:
+            std::string get_layer_name() { return to_string(this->layer_name); }
+            bounding_box get_bounds();
             path(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
             void read(json json_data) override;
             json::object_t get_json() override;
@@ -566,7 +791,7 @@ namespace open_json {
         private:
             open_json::data *file_data;
             std::vector<std::shared_ptr<annotation>> annotations;
-            std::map<std::string, std::string> attributes;
+            attribute_map attributes;
             metadata_container metadata;
         public:
             design_info(json_object *super, open_json::data *file, json json_data) : json_object(super), file_data(file) { this->read(json_data); }
@@ -582,9 +807,22 @@ namespace open_json {
             int major = 0, minor = 2, build = 0;
         } version;
         std::string original_file_name;
+        // Bytes and objects per section, only kept while memory accounting is on
+        std::shared_ptr<accounting::design_usage> memory_usage;
         
         version version_info;
         std::shared_ptr<types::design_info> design_info;
+        
+        // One top level key of the OpenJSON document. Array sections produce their elements one at a time so they can be
+        // rendered in pieces, other sections produce their whole value at index 0.
+        typedef struct json_section {
+            std::string key;
+            bool is_array = false;
+            size_t count = 1;
+            std::function<json(size_t)> get_value;
+        } json_section;
+    private:
+        // Sections stay empty in a lazily read design until they are materialized, read them through the getters below
         std::map<std::string, std::shared_ptr<types::component>> components;
         std::map<std::string, std::shared_ptr<types::component_instance>> component_instances;
         std::map<std::string, std::shared_ptr<types::net>> nets;
@@ -596,17 +834,101 @@ namespace open_json {
         std::vector<std::shared_ptr<types::pour>> pours;
         std::vector<std::shared_ptr<types::trace>> traces;
         std::vector<std::shared_ptr<types::path>> paths;
+        
+        // How a top level key is decoded, a section is only read once the sections it depends on have been
+        typedef struct section_reader {
+            std::string name;
+            std::function<void(const json &)> read;
+            std::vector<std::string> dependencies;
+        } section_reader;
+        
+        // Undecoded section of a lazily read design
+        typedef struct lazy_section {
+            size_t begin = 0, end = 0; // Byte range of the value in the document
+            accounting::account *account = nullptr;
+            std::once_flag decoded;
+        } lazy_section;
+        
+        std::once_flag spatial_index_flag, extents_flag, world_geometry_flag, connectivity_flag;
+        std::shared_ptr<spatial::spatial_index> spatial_index;
+        std::shared_ptr<bounds::extents> extents;
+        std::shared_ptr<transform::world_geometry> world_geometry;
+        std::shared_ptr<connectivity::net_graph> connectivity;
+        
+        // The text and its index are released once the last lazy section has been decoded
+        std::shared_ptr<const std::string> document;
+        std::shared_ptr<scan::structural_index> document_index;
+        std::map<std::string, std::unique_ptr<lazy_section>> lazy_sections;
+        std::atomic<size_t> undecoded_sections;
+        
+        std::vector<section_reader> get_section_readers();
+        void read_header(json &json_data);
+        void read_section(const section_reader &reader, const json &section_json, accounting::account *account);
+        void read_components(const json &components_json);
+        void read_component_instances(const json &component_instances_json);
+        void read_nets(const json &nets_json);
     public:
-        data(std::string file_name, json json_data) : json_object(nullptr), original_file_name(file_name) { this->read(json_data); }
+        data(std::string file_name, json json_data) : json_object(nullptr), original_file_name(file_name), undecoded_sections(0) { this->read(std::move(json_data)); }
+        // Lazy mode, only the version and design info are decoded up front. Every other section stays as text until it is
+        // first read through its getter or materialized.
+        data(std::string file_name, std::shared_ptr<const std::string> document_text);
+        // Decodes a section of a lazily read design along with the sections it depends on, nothing happens for sections
+        // that are already decoded or missing. Safe to call from several threads.
+        void materialize(const std::string &section);
+        void materialize_all();
+        // Each section is decoded on first access when the design was read lazily
+        const std::map<std::string, std::shared_ptr<types::component>> &get_components() { this->materialize("components"); return this->components; }
+        const std::map<std::string, std::shared_ptr<types::component_instance>> &get_component_instances() { this->materialize("component_instances"); return this->component_instances; }
+        const std::map<std::string, std::shared_ptr<types::net>> &get_nets() { this->materialize("nets"); return this->nets; }
+        const std::vector<std::shared_ptr<types::layer_option>> &get_layer_options() { this->materialize("layer_options"); return this->layer_options; }
+        const std::vector<std::shared_ptr<types::body>> &get_layout_bodies() { this->materialize("layout_bodies"); return this->layout_bodies; }
+        const std::vector<std::shared_ptr<types::layout_body_attribute>> &get_layout_body_attributes() { this->materialize("layout_body_attributes"); return this->layout_body_attributes; }
+        const std::vector<std::shared_ptr<types::layout_object>> &get_layout_objects() { this->materialize("layout_objects"); return this->layout_objects; }
+        const std::vector<std::shared_ptr<types::pcb_text>> &get_pcb_text() { this->materialize("pcb_text"); return this->pcb_text; }
+        const std::vector<std::shared_ptr<types::pour>> &get_pours() { this->materialize("pours"); return this->pours; }
+        const std::vector<std::shared_ptr<types::trace>> &get_traces() { this->materialize("trace_segments"); return this->traces; }
+        const std::vector<std::shared_ptr<types::path>> &get_paths() { this->materialize("paths"); return this->paths; }
+        // Per object, per layer and board bounds. Computed on first use like the spatial index
+        std::shared_ptr<bounds::extents> get_extents();
+        // Component footprint and symbol shapes resolved to board and sheet coordinates
+        std::shared_ptr<transform::world_geometry> get_world_geometry();
+        // Connectivity of every net in the design, for netlist export. Its reports list the dangling references of every net
+        std::shared_ptr<connectivity::net_graph> get_connectivity();
+        // Built on first use, the layout sections must not be modified afterwards
+        std::shared_ptr<spatial::spatial_index> get_spatial_index();
         void read(json json_data) override;
         json::object_t get_json() override;
+        // Only the sections the output type and only_sections need are materialized and listed, see is_section_needed
+        std::vector<json_section> get_json_sections(output_type type = output_type::ALL, const std::set<std::string> &only_sections = {});
     };
     
     class open_json_format : public eda_format {
     private:
+        converter_options options;
         std::vector<std::shared_ptr<data>> parsed_data;
+        
+        // Null when every section is kept
+        std::function<bool(const std::string &)> get_section_filter(output_type type) const;
     public:
+        open_json_format() {}
+        open_json_format(converter_options converter_settings) : options(converter_settings) {}
         void read(std::vector<std::string> files) override;
         void write(output_type type, std::string out_file) override;
+        // Single design versions of read and write, they don't touch the parsed data so several may run at once
+        // Sections that neither the output type nor the only_sections option need are dropped while lexing
+        // Streams the document through the lexer, the text is never held as a whole
+        std::shared_ptr<data> read_file(const std::string &file, std::istream &input, output_type type = output_type::ALL);
+        // For an uncompressed document that is already in memory, sections and large arrays are lexed concurrently
+        // through a structural index, see scan. Costs an index of about half the document size on top of the text.
+        std::shared_ptr<data> read_buffer(const std::string &file, const std::string &document, output_type type = output_type::ALL);
+        // Keeps the text and only decodes the sections that are materialized, see data
+        std::shared_ptr<data> read_file_lazy(const std::string &file, std::istream &input);
+        void write_file(data &file_data, output_type type, const std::string &out_file);
+        void write_stream(data &file_data, output_type type, std::ostream &output);
+        void print_stats(std::ostream &out);
+        static std::string get_design_name(const std::string &file);
+        std::string get_output_path(const std::string &design_name, const std::string &out_file) const;
     };
-};
\ No newline at end of file
+};
+
+#endif /* defined(__OPENJSON__) */
\ No newline at end of file
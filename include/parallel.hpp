@@ -0,0 +1,199 @@
+#ifndef __PARALLEL__
+#define __PARALLEL__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace open_json {
+    namespace parallel {
+        inline unsigned int get_concurrency() {
+            unsigned int threads = std::thread::hardware_concurrency();
+            return threads == 0 ? 1 : threads;
+        }
+
+        // Tracks a set of submitted tasks, the first exception thrown by any of them is kept
+        class task_group {
+            friend class work_stealing_pool;
+        private:
+            std::atomic<size_t> outstanding;
+            std::mutex error_lock;
+            std::exception_ptr error;
+        public:
+            task_group() : outstanding(0) {}
+            bool is_done() const { return this->outstanding == 0; }
+            void rethrow_if_failed();
+        };
+
+        // Every worker owns a deque, it takes its own newest tasks first and steals the oldest tasks of the others when idle.
+        // Threads waiting on a group run queued tasks instead of blocking, so tasks may submit and wait on nested groups.
+        class work_stealing_pool {
+            typedef struct task {
+                std::function<void()> function;
+                task_group *group;
+            } task;
+
+            typedef struct worker_queue {
+                std::mutex lock;
+                std::deque<task> tasks;
+            } worker_queue;
+        private:
+            std::vector<std::unique_ptr<worker_queue>> queues;
+            std::vector<std::thread> threads;
+            std::atomic<size_t> queued;
+            std::atomic<size_t> next_queue;
+            std::atomic<bool> stopping;
+            std::mutex sleep_lock;
+            std::condition_variable wake;
+
+            bool try_pop(size_t queue_index, task &next);
+            bool try_steal(size_t thief_index, task &next);
+            bool try_run_one();
+            void run(task &next);
+            void worker_loop(size_t queue_index);
+        public:
+            explicit work_stealing_pool(unsigned int thread_count);
+            ~work_stealing_pool();
+            size_t get_thread_count() const { return this->threads.size(); }
+            void submit(task_group &group, std::function<void()> function);
+            void wait(task_group &group);
+            // Sized to the machine, created on first use and kept warm for the life of the process
+            static work_stealing_pool &shared();
+        };
+
+        // Bounded multi producer multi consumer queue (Vyukov), every cell carries a sequence number so producers and consumers
+        // only ever race on their own position counter. The capacity is rounded up to a power of two.
+        template<typename value_type>
+        class bounded_queue {
+            typedef struct cell {
+                std::atomic<size_t> sequence;
+                value_type value;
+            } cell;
+        private:
+            std::unique_ptr<cell[]> cells;
+            size_t mask;
+            alignas(64) std::atomic<size_t> enqueue_position;
+            alignas(64) std::atomic<size_t> dequeue_position;
+        public:
+            explicit bounded_queue(size_t capacity) : enqueue_position(0), dequeue_position(0) {
+                size_t size = 2;
+                while (size < capacity) {
+                    size *= 2;
+                }
+                this->cells.reset(new cell[size]);
+                this->mask = size - 1;
+                for (size_t i = 0; i < size; i++) {
+                    this->cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+            bounded_queue(const bounded_queue &) = delete;
+            bounded_queue &operator=(const bounded_queue &) = delete;
+            
+            size_t get_capacity() const { return this->mask + 1; }
+            // Only exact while no other thread is pushing or popping
+            size_t get_size() const {
+                size_t enqueued = this->enqueue_position.load(std::memory_order_relaxed), dequeued = this->dequeue_position.load(std::memory_order_relaxed);
+                return enqueued > dequeued ? enqueued - dequeued : 0;
+            }
+            
+            // Returns false when the queue is full
+            bool try_push(value_type &value) {
+                size_t position = this->enqueue_position.load(std::memory_order_relaxed);
+                while (true) {
+                    cell &target = this->cells[position & this->mask];
+                    size_t sequence = target.sequence.load(std::memory_order_acquire);
+                    if (sequence == position) {
+                        if (this->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            target.value = std::move(value);
+                            target.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (sequence < position) {
+                        return false;
+                    } else {
+                        position = this->enqueue_position.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+            
+            // Returns false when the queue is empty
+            bool try_pop(value_type &value) {
+                size_t position = this->dequeue_position.load(std::memory_order_relaxed);
+                while (true) {
+                    cell &source = this->cells[position & this->mask];
+                    size_t sequence = source.sequence.load(std::memory_order_acquire);
+                    if (sequence == position + 1) {
+                        if (this->dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            value = std::move(source.value);
+                            source.value = value_type();
+                            source.sequence.store(position + this->mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    } else if (sequence < position + 1) {
+                        return false;
+                    } else {
+                        position = this->dequeue_position.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+        };
+        
+        // Tasks with dependencies, every task is started on the shared pool as soon as the tasks it depends on have finished.
+        // Dependencies must be added before their dependents. The successors of a failed task are never run.
+        class task_graph {
+            typedef struct node {
+                std::function<void()> function;
+                std::vector<size_t> successors;
+                size_t dependency_count = 0;
+                std::atomic<size_t> remaining;
+                std::exception_ptr error;
+            } node;
+        private:
+            std::vector<std::unique_ptr<node>> nodes;
+            void schedule(work_stealing_pool &pool, task_group &group, size_t index);
+        public:
+            size_t add(std::function<void()> function, const std::vector<size_t> &dependencies = std::vector<size_t>());
+            bool has_failed(size_t index) const { return this->nodes.at(index)->error != nullptr; }
+            // Rethrows the exception of the first failed task in the order the tasks were added
+            void run();
+        };
+        
+        // Calls function(index) for every index in [0, count) on the shared pool, the calling thread takes part in the work.
+        // The first exception thrown by any call is rethrown once every task has stopped.
+        template<typename function_type>
+        void for_each_index(size_t count, function_type function) {
+            if (count == 0) {
+                return;
+            }
+            if (count == 1 || get_concurrency() <= 1) {
+                for (size_t index = 0; index < count; index++) {
+                    function(index);
+                }
+                return;
+            }
+
+            work_stealing_pool &pool = work_stealing_pool::shared();
+            std::shared_ptr<std::atomic<size_t>> next_index = std::make_shared<std::atomic<size_t>>(0);
+            task_group group;
+            size_t task_count = std::min<size_t>(count, pool.get_thread_count() + 1);
+            for (size_t i = 0; i < task_count; i++) {
+                pool.submit(group, [next_index, count, &function]() {
+                    for (size_t index = (*next_index)++; index < count; index = (*next_index)++) {
+                        function(index);
+                    }
+                });
+            }
+            pool.wait(group);
+            group.rethrow_if_failed();
+        }
+    };
+};
+
+#endif /* defined(__PARALLEL__) */
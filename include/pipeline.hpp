@@ -0,0 +1,48 @@
+#ifndef __PIPELINE__
+#define __PIPELINE__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "converter.hpp"
+#include "cache.hpp"
+
+namespace open_json {
+    namespace pipeline {
+        typedef struct stage_stats {
+            std::string name;
+            size_t items = 0, bytes = 0;
+            double busy_seconds = 0.0; // Time spent working, not waiting on a queue
+        } stage_stats;
+        
+        typedef struct queue_stats {
+            std::string name;
+            size_t capacity = 0, max_occupancy = 0;
+            size_t samples = 0, occupancy_sum = 0; // Occupancy is sampled after every push
+            size_t full_waits = 0; // Pushes that had to wait for the consumer
+        } queue_stats;
+        
+        // Three stages with a thread each, file reading, parsing and writing, connected by bounded queues.
+        // At most queue_capacity designs wait between two stages, so memory doesn't grow with the number of inputs.
+        class conversion_pipeline {
+        private:
+            converter_options options;
+            size_t queue_capacity;
+            cache::conversion_cache output_cache;
+            std::vector<stage_stats> stages;
+            std::vector<queue_stats> queues;
+            double wall_seconds = 0.0;
+        public:
+            explicit conversion_pipeline(converter_options converter_settings, size_t capacity = 2) : options(converter_settings), queue_capacity(capacity), output_cache(converter_settings.cache_directory, converter_settings.cache_max_bytes) {}
+            // Designs found in the conversion cache skip the parse and write stages, their cached output is placed instead.
+            // Stops at the first file that fails to parse or write, designs parsed before a parse error are still written
+            bool run(const std::vector<std::string> &files, output_type type, const std::string &out_file);
+            const std::vector<stage_stats> &get_stage_stats() const { return this->stages; }
+            const std::vector<queue_stats> &get_queue_stats() const { return this->queues; }
+            void print_report(std::ostream &out) const;
+        };
+    };
+};
+
+#endif /* defined(__PIPELINE__) */
@@ -0,0 +1,50 @@
+#ifndef __SCAN__
+#define __SCAN__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+
+namespace open_json {
+    namespace scan {
+        // Byte range of the value of one top level key, the value itself is left undecoded
+        typedef struct section_range {
+            std::string key;
+            size_t begin = 0, end = 0;
+        } section_range;
+
+        // Offsets of every brace, bracket, colon and comma outside of strings, found 64 bytes at a time (simdjson stage 1).
+        // Quotes and backslashes are classified with SIMD compares, the string mask follows from a prefix xor of the unescaped quotes.
+        // Documents of 4 GiB and more are not indexed, is_usable is false for them.
+        class structural_index {
+        private:
+            std::vector<uint32_t> positions;
+            bool usable;
+        public:
+            explicit structural_index(const std::string &document);
+            bool is_usable() const { return this->usable; }
+            const std::vector<uint32_t> &get_positions() const { return this->positions; }
+            // Index of the first structural character at or after the given offset
+            size_t lower_bound(size_t offset) const;
+        };
+
+        // Walks the structure of a JSON object document without decoding it, nested values are skipped through the index.
+        // Throws a parse_exception when the structure is malformed, the values themselves are checked once they are decoded.
+        std::vector<section_range> find_sections(const std::string &document, const structural_index &index);
+        std::vector<section_range> find_sections(const std::string &document);
+        // Byte ranges of runs of at most elements_per_chunk whole elements of the array at [begin, end), without the brackets
+        std::vector<std::pair<size_t, size_t>> split_array(const std::string &document, const structural_index &index, size_t begin, size_t end, size_t elements_per_chunk);
+        // Large arrays are split into chunks that are lexed on the shared pool, anything else is lexed in one go
+        nlohmann::json parse_value(const std::string &document, const structural_index &index, size_t begin, size_t end);
+        // Lexes every top level section that keep_section accepts concurrently, the others are skipped unread. Errors are
+        // only as precise as the lexer of the failing piece, fall back to lexing the whole document to report them.
+        nlohmann::json parse_document(const std::string &document, std::function<bool(const std::string &)> keep_section = nullptr);
+    };
+};
+
+#endif /* defined(__SCAN__) */
@@ -0,0 +1,27 @@
+#ifndef __SERIALIZER__
+#define __SERIALIZER__
+
+#include <ostream>
+#include <set>
+#include <string>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace serialize {
+        // Array sections are rendered in chunks of this many elements
+        const size_t chunk_size = 512;
+        const int indent_width = 4;
+        
+        // Same text as std::setw(4) << value, with every line after the first indented as if the value sat depth levels deep
+        std::string render(const json &value, size_t depth);
+        
+        // Writes the document of data::get_json, byte for byte as std::setw(4) would, without building the whole tree.
+        // Sections and chunks of the large ones are rendered on the shared pool and stitched together in key order.
+        // Schematic and layout output only contain their half of the design and sections left out by only_sections are
+        // omitted, see data::get_json_sections.
+        void write(std::ostream &out, data &file, double curve_tolerance = 0.0, output_type type = output_type::ALL, const std::set<std::string> &only_sections = {});
+    };
+};
+
+#endif /* defined(__SERIALIZER__) */
@@ -0,0 +1,50 @@
+#ifndef __SERVER__
+#define __SERVER__
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "converter.hpp"
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace server {
+        // Longest request line a client may send, inline designs included. The connection is closed once it is exceeded.
+        const size_t max_request_size = size_t(256) << 20;
+        
+        // Conversion daemon on a Unix domain socket, every line a client sends is one JSON job and gets one JSON line back:
+        //   {"input": "<path>" | "data": "<OpenJSON text>", "eda_type": "open_json", "output_type": "all" | "schematic" | "layout",
+        //    "output": "<path>" (optional, the result is returned inline without it), "flatten_curves": <nm> (optional),
+        //    "compression": "none" | "gzip" | "zstd" (optional, written output only)}
+        //   {"ok": true, "output": "<path>" | "result": "<OpenJSON text>", "messages": "<diagnostics>"} or {"ok": false, "error": "..."}
+        // {"command": "shutdown"} stops the server. The thread pool and caches stay warm between jobs.
+        class conversion_server {
+        private:
+            converter_options options;
+            std::string socket_path;
+            int listen_socket = -1;
+            std::atomic<bool> stopping;
+            std::mutex connections_lock;
+            std::condition_variable connections_closed;
+            std::set<int> connections; // Open client sockets, each one served by its own detached thread
+            std::atomic<size_t> jobs, failures;
+            
+            void serve_connection(int connection);
+            json run_job(const json &request);
+            void stop();
+        public:
+            conversion_server(converter_options converter_settings, const std::string &path) : options(converter_settings), socket_path(path), stopping(false), jobs(0), failures(0) {}
+            ~conversion_server();
+            // Blocks until a shutdown command arrives, returns false if the socket couldn't be set up
+            bool run();
+        };
+        
+        bool parse_eda_type(const std::string &name, eda_type &type);
+        bool parse_output_type(const std::string &name, output_type &type);
+    };
+};
+
+#endif /* defined(__SERVER__) */
@@ -0,0 +1,68 @@
+#ifndef __SPATIAL__
+#define __SPATIAL__
+
+#include <string>
+#include <map>
+#include <vector>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace spatial {
+        enum class object_type {
+            TRACE,
+            POUR,
+            PATH,
+            LAYOUT_BODY,
+            PCB_TEXT
+        };
+
+        typedef struct entry {
+            types::bounding_box bounds;
+            object_type type;
+            size_t index; // Index into the matching open_json::data vector
+            entry(types::bounding_box box, object_type object, size_t object_index) : bounds(box), type(object), index(object_index) {}
+        } entry;
+
+        // Static R-tree bulk loaded with the Sort-Tile-Recursive algorithm, it can't be modified after being built
+        class rtree {
+            typedef struct node {
+                types::bounding_box bounds;
+                size_t first = 0; // First child node, or first entry for leaves
+                size_t count = 0;
+                bool leaf = true;
+            } node;
+        private:
+            std::vector<entry> entries;
+            std::vector<node> nodes; // The root is always the last node
+        public:
+            static const size_t node_capacity = 16;
+            // Slices smaller than this are sorted on the calling thread
+            static const size_t parallel_threshold = 1 << 16;
+
+            rtree() {}
+            explicit rtree(std::vector<entry> items);
+            size_t size() const { return this->entries.size(); }
+            types::bounding_box get_bounds() const { return this->nodes.empty() ? types::bounding_box() : this->nodes.back().bounds; }
+            void query(const types::bounding_box &window, std::vector<entry> &results) const;
+            // Distances are measured to the entry bounds, closest first
+            std::vector<entry> nearest(const types::point &position, size_t count) const;
+        };
+
+        class spatial_index {
+        private:
+            std::map<std::string, rtree> layers;
+        public:
+            explicit spatial_index(open_json::data &file);
+            std::vector<std::string> get_layer_names() const;
+            const rtree *get_layer(const std::string &layer_name) const;
+            std::vector<entry> query(const std::string &layer_name, const types::bounding_box &window) const;
+            std::vector<entry> query(const std::string &layer_name, const types::point &position) const;
+            std::vector<entry> nearest(const std::string &layer_name, const types::point &position, size_t count = 1) const;
+        };
+
+        types::json_object *resolve(open_json::data &file, const entry &item);
+    };
+};
+
+#endif /* defined(__SPATIAL__) */
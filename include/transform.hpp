@@ -0,0 +1,51 @@
+#ifndef __TRANSFORM__
+#define __TRANSFORM__
+
+#include <string>
+#include <vector>
+
+#include "openjson.hpp"
+
+namespace open_json {
+    namespace transform {
+        // x' = xx * x + xy * y + tx, y' = yx * x + yy * y + ty
+        typedef struct affine {
+            double xx = 1.0, xy = 0.0, tx = 0.0;
+            double yx = 0.0, yy = 1.0, ty = 0.0;
+            // Mirror about the y axis, then rotate, then translate. Rotation is in OpenJSON units of pi
+            static affine placement(const types::point &position, double rotation, bool mirror);
+            // The transform that applies this one first and then outer
+            affine then(const affine &outer) const;
+        } affine;
+
+        // Results are rounded to the nearest nanometre, ties to even, on both the SIMD and scalar paths.
+        // Coordinates must stay within +/-2^51 so they convert exactly to doubles.
+        void apply(const affine &matrix, const types::point *input, types::point *output, size_t count);
+        void apply_scalar(const affine &matrix, const types::point *input, types::point *output, size_t count);
+
+        typedef struct world_shape {
+            std::shared_ptr<types::shapes::shape> shape; // The component local definition
+            std::string layer_name;
+            std::vector<types::point> vertices; // shape::get_vertices in world coordinates
+            double rotation = 0.0; // Placement rotation in units of pi, to add to the shape's own rotation
+            bool mirrored = false;
+        } world_shape;
+
+        typedef struct placed_instance {
+            std::shared_ptr<types::component_instance> instance;
+            affine footprint_transform;
+            std::vector<world_shape> footprint_shapes; // Board coordinates
+            std::vector<world_shape> symbol_shapes; // Sheet coordinates
+        } placed_instance;
+
+        typedef struct world_geometry {
+            std::vector<placed_instance> instances; // Ordered by instance id
+        } world_geometry;
+
+        // Instances are placed in parallel batches
+        std::shared_ptr<world_geometry> place_instances(open_json::data &file);
+        static const size_t instance_batch_size = 64;
+    };
+};
+
+#endif /* defined(__TRANSFORM__) */
@@ -0,0 +1,167 @@
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "instrument.hpp"
+#include "json.hpp"
+
+std::atomic<bool> open_json::instrument::tracing(false);
+
+namespace {
+    std::mutex registry_lock;
+    
+    typedef struct span {
+        const std::string *name; // Metric names live as long as the process
+        std::string detail;
+        open_json::instrument::clock_type::time_point start;
+        uint64_t duration;
+    } span;
+    
+    typedef struct thread_trace {
+        size_t id;
+        std::string name;
+        std::mutex lock;
+        std::vector<span> spans;
+    } thread_trace;
+    
+    std::mutex trace_lock;
+    open_json::instrument::clock_type::time_point trace_start;
+    
+    // Kept after their thread exits so its spans still make it into the trace
+    std::vector<std::shared_ptr<thread_trace>> &get_thread_traces() {
+        static std::vector<std::shared_ptr<thread_trace>> traces;
+        return traces;
+    }
+    
+    thread_trace &get_thread_trace() {
+        thread_local std::shared_ptr<thread_trace> trace;
+        if (!trace) {
+            trace = std::make_shared<thread_trace>();
+            std::lock_guard<std::mutex> lock(trace_lock);
+            trace->id = get_thread_traces().size() + 1;
+            trace->name = "thread " + std::to_string(trace->id);
+            get_thread_traces().push_back(trace);
+        }
+        return *trace;
+    }
+    
+    double to_microseconds(open_json::instrument::clock_type::duration time) {
+        return std::chrono::duration<double, std::micro>(time).count();
+    }
+    
+    std::map<std::string, std::unique_ptr<open_json::instrument::metric>> &get_registry() {
+        static std::map<std::string, std::unique_ptr<open_json::instrument::metric>> registry;
+        return registry;
+    }
+};
+
+void open_json::instrument::metric::reset() {
+    this->calls = 0;
+    this->nanoseconds = 0;
+    this->amount = 0;
+}
+
+open_json::instrument::metric &open_json::instrument::get_metric(const std::string &name) {
+    std::lock_guard<std::mutex> lock(registry_lock);
+    std::unique_ptr<metric> &entry = get_registry()[name];
+    if (!entry) {
+        entry.reset(new metric(name));
+    }
+    return *entry;
+}
+
+void open_json::instrument::reset() {
+    std::lock_guard<std::mutex> lock(registry_lock);
+    for (auto &entry : get_registry()) {
+        entry.second->reset();
+    }
+}
+
+void open_json::instrument::print_table(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(registry_lock);
+    out<<"Phases (time summed over threads):"<<std::endl;
+    out<<"  "<<std::left<<std::setw(32)<<"phase"<<std::right<<std::setw(10)<<"calls"<<std::setw(14)<<"total ms"<<std::setw(14)<<"mean us"<<std::setw(14)<<"amount"<<std::endl;
+    for (auto &entry : get_registry()) {
+        const metric &phase = *entry.second;
+        if (phase.get_calls() == 0 && phase.get_amount() == 0) {
+            continue;
+        }
+        out<<"  "<<std::left<<std::setw(32)<<phase.get_name()<<std::right<<std::setw(10)<<phase.get_calls()<<std::fixed<<std::setprecision(3)
+           <<std::setw(14)<<phase.get_nanoseconds() / 1e6<<std::setw(14)<<(phase.get_calls() > 0 ? phase.get_nanoseconds() / 1e3 / phase.get_calls() : 0.0)
+           <<std::setw(14)<<phase.get_amount()<<std::endl;
+    }
+    out.unsetf(std::ios_base::floatfield);
+}
+
+void open_json::instrument::write_json(std::ostream &out) {
+    nlohmann::json phases(nlohmann::json::value_t::object);
+    {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        for (auto &entry : get_registry()) {
+            const metric &phase = *entry.second;
+            if (phase.get_calls() == 0 && phase.get_amount() == 0) {
+                continue;
+            }
+            phases[phase.get_name()] = {
+                {"calls", phase.get_calls()},
+                {"nanoseconds", phase.get_nanoseconds()},
+                {"amount", phase.get_amount()}
+            };
+        }
+    }
+    out<<std::setw(4)<<nlohmann::json({{"phases", phases}})<<std::endl;
+}
+
+void open_json::instrument::start_tracing() {
+    {
+        std::lock_guard<std::mutex> lock(trace_lock);
+        trace_start = clock_type::now();
+    }
+    tracing = true;
+}
+
+void open_json::instrument::set_thread_name(const std::string &name) {
+    thread_trace &trace = get_thread_trace();
+    std::lock_guard<std::mutex> lock(trace.lock);
+    trace.name = name;
+}
+
+void open_json::instrument::record_span(const metric &timed, clock_type::time_point start, uint64_t duration, const std::string &detail) {
+    thread_trace &trace = get_thread_trace();
+    std::lock_guard<std::mutex> lock(trace.lock);
+    trace.spans.push_back({&timed.get_name(), detail, start, duration});
+}
+
+void open_json::instrument::write_trace(std::ostream &out) {
+    std::vector<std::shared_ptr<thread_trace>> traces;
+    clock_type::time_point start;
+    {
+        std::lock_guard<std::mutex> lock(trace_lock);
+        traces = get_thread_traces();
+        start = trace_start;
+    }
+    // Written by hand, a run can hold millions of spans and building them as one document would double the memory
+    out<<"{\"displayTimeUnit\":\"ms\",\"traceEvents\":["<<std::endl;
+    out<<std::fixed<<std::setprecision(3);
+    bool first = true;
+    for (std::shared_ptr<thread_trace> &trace : traces) {
+        std::lock_guard<std::mutex> lock(trace->lock);
+        out<<(first ? "" : ",\n")<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"<<trace->id<<",\"args\":{\"name\":"<<nlohmann::json(trace->name).dump()<<"}}";
+        first = false;
+        for (const span &event : trace->spans) {
+            if (event.start < start) {
+                continue;
+            }
+            out<<",\n{\"name\":"<<nlohmann::json(*event.name).dump()<<",\"cat\":\"open_json\",\"ph\":\"X\",\"pid\":1,\"tid\":"<<trace->id
+               <<",\"ts\":"<<to_microseconds(event.start - start)<<",\"dur\":"<<event.duration / 1e3;
+            if (!event.detail.empty()) {
+                out<<",\"args\":{\"detail\":"<<nlohmann::json(event.detail).dump()<<"}";
+            }
+            out<<"}";
+        }
+    }
+    out<<std::endl<<"]}"<<std::endl;
+    out.unsetf(std::ios_base::floatfield);
+}
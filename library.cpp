@@ -0,0 +1,165 @@
+#include "library.hpp"
+#include "hash.hpp"
+
+namespace {
+    const uint64_t high_seed = 0x9e3779b97f4a7c15ULL;
+    
+    typedef struct key_state {
+        open_json::hash::xxhash64 low, high;
+        key_state() : low(0), high(high_seed) {}
+        void update(const void *data, size_t length) {
+            this->low.update(data, length);
+            this->high.update(data, length);
+        }
+        void update(const std::string &text) {
+            uint64_t length = text.size();
+            this->update(&length, sizeof(length));
+            this->update(text.data(), text.size());
+        }
+    } key_state;
+    
+    // Walks the value instead of dumping it, a type tag and length prefixes keep different documents from feeding the same bytes
+    void hash_json(key_state &state, const json &value) {
+        unsigned char tag = static_cast<unsigned char>(value.type());
+        state.update(&tag, sizeof(tag));
+        switch (value.type()) {
+            case json::value_t::object: {
+                uint64_t count = value.size();
+                state.update(&count, sizeof(count));
+                for (json::const_iterator it = value.begin(); it != value.end(); it++) {
+                    state.update(it.key());
+                    hash_json(state, it.value());
+                }
+                break;
+            }
+            case json::value_t::array: {
+                uint64_t count = value.size();
+                state.update(&count, sizeof(count));
+                for (const json &element : value) {
+                    hash_json(state, element);
+                }
+                break;
+            }
+            case json::value_t::string:
+                state.update(value.get_ref<const std::string&>());
+                break;
+            case json::value_t::boolean: {
+                unsigned char flag = value.get<bool>() ? 1 : 0;
+                state.update(&flag, sizeof(flag));
+                break;
+            }
+            case json::value_t::number_integer: {
+                int64_t number = value.get<int64_t>();
+                state.update(&number, sizeof(number));
+                break;
+            }
+            case json::value_t::number_unsigned: {
+                uint64_t number = value.get<uint64_t>();
+                state.update(&number, sizeof(number));
+                break;
+            }
+            case json::value_t::number_float: {
+                double number = value.get<double>();
+                state.update(&number, sizeof(number));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+};
+
+open_json::library::component_key open_json::library::make_key(const std::string &library_id, bool legacy_format, const json &component_json) {
+    key_state state;
+    state.update(library_id);
+    unsigned char legacy = legacy_format ? 1 : 0;
+    state.update(&legacy, sizeof(legacy));
+    hash_json(state, component_json);
+    component_key key;
+    key.low = state.low.digest();
+    key.high = state.high.digest();
+    return key;
+}
+
+void open_json::library::component_cache::set_capacity(size_t max_entries) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->capacity = max_entries;
+    while (this->entries.size() > this->capacity) {
+        this->entries.erase(this->recently_used.back());
+        this->recently_used.pop_back();
+        this->evictions++;
+    }
+}
+
+std::shared_ptr<open_json::types::component> open_json::library::component_cache::get(const std::string &library_id, bool legacy_format, const json &component_json, const std::function<std::shared_ptr<types::component>()> &read) {
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (this->capacity == 0) {
+            return read();
+        }
+    }
+    component_key key = make_key(library_id, legacy_format, component_json);
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+        auto found = this->entries.find(key);
+        if (found != this->entries.end()) {
+            this->recently_used.splice(this->recently_used.begin(), this->recently_used, found->second.position);
+            this->hits++;
+            std::shared_ptr<types::component> component = found->second.component;
+            diagnostic_capture::entry_list diagnostics = found->second.diagnostics;
+            guard.unlock();
+            diagnostic_capture::write_entries(diagnostics);
+            return component;
+        }
+        this->misses++;
+    }
+    
+    // Read outside the lock, two designs missing on the same part at once both read it and the first one is kept
+    diagnostic_capture capture;
+    std::shared_ptr<types::component> component;
+    try {
+        diagnostic_capture::scope scope(capture);
+        component = read();
+    } catch (...) {
+        capture.replay();
+        throw;
+    }
+    diagnostic_capture::entry_list diagnostics = capture.get_entries();
+    diagnostic_capture::write_entries(diagnostics);
+    
+    std::lock_guard<std::mutex> guard(this->lock);
+    if (this->capacity == 0 || this->entries.find(key) != this->entries.end()) {
+        return component;
+    }
+    this->recently_used.push_front(key);
+    entry &added = this->entries[key];
+    added.component = component;
+    added.diagnostics = diagnostics;
+    added.position = this->recently_used.begin();
+    while (this->entries.size() > this->capacity) {
+        this->entries.erase(this->recently_used.back());
+        this->recently_used.pop_back();
+        this->evictions++;
+    }
+    return component;
+}
+
+size_t open_json::library::component_cache::get_size() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->entries.size();
+}
+
+void open_json::library::component_cache::print_stats(std::ostream &out) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    size_t lookups = this->hits + this->misses;
+    out<<"Component cache: "<<this->entries.size()<<" of "<<this->capacity<<" entries, "<<this->hits<<" hits, "<<this->misses<<" misses";
+    if (lookups > 0) {
+        out<<" ("<<(100 * this->hits / lookups)<<"% hit rate)";
+    }
+    out<<", "<<this->evictions<<" evicted"<<std::endl;
+}
+
+open_json::library::component_cache &open_json::library::component_cache::shared() {
+    static component_cache cache(4096);
+    return cache;
+}
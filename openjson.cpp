@@ -1,10 +1,135 @@
 #include <chrono>
+#include <cmath>
 #include <istream>
+#include <iterator>
 #include <ostream>
 #include <fstream>
 
 #include "converter.hpp"
 #include "openjson.hpp"
+#include "arena.hpp"
+#include "bounds.hpp"
+#include "compression.hpp"
+#include "connectivity.hpp"
+#include "flatten.hpp"
+#include "instrument.hpp"
+#include "library.hpp"
+#include "parallel.hpp"
+#include "scan.hpp"
+#include "serialize.hpp"
+#include "spatial.hpp"
+#include "transform.hpp"
+
+// Diagnostics
+namespace {
+    thread_local open_json::diagnostic_capture *active_capture = nullptr;
+};
+
+int open_json::diagnostic_capture::capture_buffer::sync() {
+    if (!this->str().empty()) {
+        this->entries.emplace_back(this->is_error, this->str());
+        this->str("");
+    }
+    return 0;
+}
+
+open_json::diagnostic_capture::scope::scope(diagnostic_capture &capture) : previous(active_capture) {
+    active_capture = &capture;
+}
+
+open_json::diagnostic_capture::scope::~scope() {
+    active_capture = this->previous;
+}
+
+void open_json::diagnostic_capture::replay() {
+    this->messages.flush();
+    this->errors.flush();
+    write_entries(this->entries);
+    this->entries.clear();
+}
+
+open_json::diagnostic_capture::entry_list open_json::diagnostic_capture::get_entries() {
+    this->messages.flush();
+    this->errors.flush();
+    return this->entries;
+}
+
+void open_json::diagnostic_capture::write_entries(const entry_list &entries) {
+    for (auto &entry : entries) {
+        (entry.first ? error_stream() : message_stream())<<entry.second<<std::flush;
+    }
+}
+
+std::string open_json::diagnostic_capture::get_text() {
+    this->messages.flush();
+    this->errors.flush();
+    std::string text;
+    for (auto &entry : this->entries) {
+        text += entry.second;
+    }
+    return text;
+}
+
+std::ostream &open_json::message_stream() {
+    return active_capture != nullptr ? active_capture->messages : std::cout;
+}
+
+std::ostream &open_json::error_stream() {
+    return active_capture != nullptr ? active_capture->errors : std::cerr;
+}
+
+// Sections
+const std::vector<open_json::section_info> &open_json::get_section_table() {
+    // Component definitions and instances carry both the symbols and the footprints
+    static const std::vector<section_info> table = {
+        {"version", true, true, {}},
+        {"design_attributes", true, true, {}},
+        {"design_info", true, true, {}},
+        {"components", true, true, {}},
+        {"component_instances", true, true, {"components"}},
+        {"nets", true, false, {"component_instances"}},
+        {"layer_options", false, true, {}},
+        {"layout_bodies", false, true, {}},
+        {"layout_body_attributes", false, true, {}},
+        {"layout_objects", false, true, {}},
+        {"pcb_text", false, true, {}},
+        {"pours", false, true, {}},
+        {"trace_segments", false, true, {}},
+        {"paths", false, true, {}}
+    };
+    return table;
+}
+
+const open_json::section_info *open_json::find_section_info(const std::string &key) {
+    for (const section_info &section : get_section_table()) {
+        if (section.key == key) {
+            return &section;
+        }
+    }
+    return nullptr;
+}
+
+bool open_json::is_section_needed(const std::string &key, output_type type, const std::set<std::string> &only_sections) {
+    if (key == "version" || key == "design_attributes" || key == "design_info" || (type == output_type::ALL && only_sections.empty())) {
+        return true;
+    }
+    std::function<bool(const section_info &)> depends_on = [&](const section_info &section) {
+        for (const std::string &dependency : section.dependencies) {
+            const section_info *dependency_info = find_section_info(dependency);
+            if (dependency == key || (dependency_info != nullptr && depends_on(*dependency_info))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (const section_info &section : get_section_table()) {
+        bool selected = (only_sections.empty() || only_sections.count(section.key) > 0) && (type == output_type::ALL || (type == output_type::SCHEMATIC ? section.schematic : section.layout));
+        if (selected && (section.key == key || depends_on(section))) {
+            return true;
+        }
+    }
+    return false;
+}
 
 // Factory
 open_json::types::shapes::shape_registry_type open_json::types::shapes::shape_registry = {
@@ -50,7 +175,110 @@ std::map<open_json::types::shapes::shape_type, std::string> open_json::types::sh
 };
 
 // Data
-void open_json::data::read(json json_data) {
+namespace {
+    const size_t object_chunk_size = 1024;
+    
+    // Large arrays are decoded in chunks on the shared pool. Every chunk constructs its objects in one arena and
+    // the chunks are appended in order, so the result is the same as decoding the array front to back.
+    template<typename object_type>
+    void read_objects(open_json::data *file, const json &objects_json, std::vector<std::shared_ptr<object_type>> &objects) {
+        if (!objects_json.is_array()) {
+            for (json::object_t json_object : objects_json) {
+                objects.emplace_back(new object_type(dynamic_cast<open_json::types::json_object*>(file), file, json_object));
+            }
+            return;
+        }
+        
+        size_t chunk_count = (objects_json.size() + object_chunk_size - 1) / object_chunk_size;
+        std::vector<std::vector<std::shared_ptr<object_type>>> chunks(chunk_count);
+        std::vector<open_json::diagnostic_capture> diagnostics(chunk_count);
+        std::vector<std::exception_ptr> errors(chunk_count);
+        open_json::accounting::account *account = open_json::accounting::current_account();
+        open_json::parallel::for_each_index(chunk_count, [&](size_t chunk) {
+            size_t first = chunk * object_chunk_size, last = std::min(objects_json.size(), first + object_chunk_size);
+            open_json::diagnostic_capture::scope capture(diagnostics[chunk]);
+            open_json::accounting::account_scope charged(account);
+            std::shared_ptr<open_json::arena::object_arena<object_type>> arena = std::make_shared<open_json::arena::object_arena<object_type>>(last - first);
+            chunks[chunk].reserve(last - first);
+            try {
+                for (size_t index = first; index < last; index++) {
+                    json::object_t json_object = objects_json[index];
+                    chunks[chunk].emplace_back(arena, arena->emplace(dynamic_cast<open_json::types::json_object*>(file), file, json_object));
+                }
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        });
+        
+        objects.reserve(objects.size() + objects_json.size());
+        for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+            diagnostics[chunk].replay();
+            objects.insert(objects.end(), chunks[chunk].begin(), chunks[chunk].end());
+            if (errors[chunk]) {
+                std::rethrow_exception(errors[chunk]);
+            }
+        }
+    }
+};
+
+open_json::data::data(std::string file_name, std::shared_ptr<const std::string> document_text) : json_object(nullptr), original_file_name(file_name), document(document_text), undecoded_sections(0) {
+    std::vector<scan::section_range> ranges;
+    {
+        static instrument::metric &scan_timing = instrument::get_metric("scan");
+        instrument::scoped_timer timer(scan_timing, this->original_file_name);
+        this->document_index = std::make_shared<scan::structural_index>(*this->document);
+        ranges = scan::find_sections(*this->document, *this->document_index);
+        scan_timing.add(this->document->size());
+    }
+    json header(json::value_t::object);
+    for (const scan::section_range &range : ranges) {
+        if (range.key == "version" || range.key == "design_attributes" || range.key == "design_info") {
+            header[range.key] = scan::parse_value(*this->document, *this->document_index, range.begin, range.end);
+        } else {
+            this->lazy_sections[range.key] = std::unique_ptr<lazy_section>(new lazy_section());
+            this->lazy_sections[range.key]->begin = range.begin;
+            this->lazy_sections[range.key]->end = range.end;
+        }
+    }
+    this->read_header(header);
+    this->undecoded_sections = this->lazy_sections.size();
+    if (this->lazy_sections.empty()) {
+        this->document.reset();
+        this->document_index.reset();
+    }
+    if (accounting::is_tracking()) {
+        // Accounts are created up front, sections may be materialized from several threads
+        this->memory_usage = std::make_shared<accounting::design_usage>(this->original_file_name);
+        for (const section_reader &reader : this->get_section_readers()) {
+            std::map<std::string, std::unique_ptr<lazy_section>>::iterator lazy = this->lazy_sections.find(reader.name);
+            if (lazy != this->lazy_sections.end()) {
+                lazy->second->account = this->memory_usage->get_account(reader.name);
+            }
+        }
+    }
+}
+
+std::vector<open_json::data::section_reader> open_json::data::get_section_readers() {
+    std::vector<section_reader> readers = {
+        {"components", [this](const json &section) { this->read_components(section); }, {}},
+        {"component_instances", [this](const json &section) { this->read_component_instances(section); }, {}},
+        {"layer_options", [this](const json &section) { read_objects(this, section, this->layer_options); }, {}},
+        {"layout_bodies", [this](const json &section) { read_objects(this, section, this->layout_bodies); }, {}},
+        {"layout_body_attributes", [this](const json &section) { read_objects(this, section, this->layout_body_attributes); }, {}},
+        {"layout_objects", [this](const json &section) { read_objects(this, section, this->layout_objects); }, {}},
+        {"nets", [this](const json &section) { this->read_nets(section); }, {}},
+        {"pcb_text", [this](const json &section) { read_objects(this, section, this->pcb_text); }, {}},
+        {"pours", [this](const json &section) { read_objects(this, section, this->pours); }, {}},
+        {"trace_segments", [this](const json &section) { read_objects(this, section, this->traces); }, {}},
+        {"paths", [this](const json &section) { read_objects(this, section, this->paths); }, {}}
+    };
+    for (section_reader &reader : readers) {
+        reader.dependencies = find_section_info(reader.name)->dependencies;
+    }
+    return readers;
+}
+
+void open_json::data::read_header(json &json_data) {
     if (json_data.find("version") != json_data.end()) {
         // TODO Move the hard-coded current version number
         std::vector<std::string> tokens = split(open_json::get_value_or_default<std::string>(json_data["version"], "file_version", "0.2.0"), "\\.");
@@ -60,7 +288,7 @@ void open_json::data::read(json json_data) {
                 this->version_info.minor = std::stoi(tokens[1]);
                 this->version_info.build = std::stoi(tokens[2]);
             } catch(...) {
-                std::cerr<<"Invalid file version assuming: "<<this->version_info.major<<"."<<this->version_info.minor<<"."<<this->version_info.build<<std::endl;
+                error_stream()<<"Invalid file version assuming: "<<this->version_info.major<<"."<<this->version_info.minor<<"."<<this->version_info.build<<std::endl;
             }
         }
         this->version_info.exporter = open_json::get_value_or_default<std::string>(json_data["version"], "exporter", "None");
@@ -68,178 +296,325 @@ void open_json::data::read(json json_data) {
     
     if (this->version_info.major < 1 && this->version_info.minor < 2) {
         // TODO Move the hard-coded current version number
-        std::cout<<"Attempting to upgrade the file format from version: "<<this->version_info.major<<"."<<this->version_info.minor<<"."<<this->version_info.build<<" to 0.2.0"<<std::endl;
+        message_stream()<<"Attempting to upgrade the file format from version: "<<this->version_info.major<<"."<<this->version_info.minor<<"."<<this->version_info.build<<" to 0.2.0"<<std::endl;
     }
     
     if (json_data.find("design_attributes") != json_data.end()) {
         design_info = std::shared_ptr<types::design_info>(new types::design_info(dynamic_cast<types::json_object*>(this), this, json_data["design_info"]));
     }
-    
-    if (json_data.find("components") != json_data.end()) {
-        json componentsJson = json_data["components"];
-        for (json::iterator it = componentsJson.begin(); it != componentsJson.end(); it++) {
-            this->components[it.key()] = std::shared_ptr<types::component>(new types::component(dynamic_cast<types::json_object*>(this), this, it.value(), it.key()));
+}
+
+void open_json::data::read_section(const section_reader &reader, const json &section_json, accounting::account *account) {
+    instrument::metric &timing = instrument::get_metric("read." + reader.name);
+    accounting::account_scope charged(account);
+    instrument::scoped_timer timer(timing, this->original_file_name);
+    reader.read(section_json);
+    timing.add(section_json.size());
+}
+
+void open_json::data::read(json json_data) {
+    this->read_header(json_data);
+    
+    // Only component instances (definitions) and nets (instances) depend on other sections, the rest are decoded concurrently.
+    // Every section reports into its own capture, the diagnostics are written out in the usual section order afterwards.
+    parallel::task_graph graph;
+    std::vector<section_reader> readers = this->get_section_readers();
+    std::vector<std::unique_ptr<diagnostic_capture>> diagnostics;
+    std::map<std::string, size_t> tasks;
+    if (accounting::is_tracking()) {
+        this->memory_usage = std::make_shared<accounting::design_usage>(this->original_file_name);
+    }
+    for (const section_reader &reader : readers) {
+        diagnostics.emplace_back(new diagnostic_capture());
+        diagnostic_capture *capture = diagnostics.back().get();
+        json::const_iterator section = json_data.find(reader.name);
+        const json *section_json = section != json_data.end() ? &*section : nullptr;
+        accounting::account *account = this->memory_usage && section_json != nullptr ? this->memory_usage->get_account(reader.name) : nullptr;
+        std::vector<size_t> dependencies;
+        for (const std::string &dependency : reader.dependencies) {
+            dependencies.push_back(tasks.at(dependency));
         }
+        const section_reader *task_reader = &reader;
+        tasks[reader.name] = graph.add([this, capture, section_json, task_reader, account]() {
+            if (section_json != nullptr) {
+                diagnostic_capture::scope scope(*capture);
+                this->read_section(*task_reader, *section_json, account);
+            }
+        }, dependencies);
     }
     
-    if (json_data.find("component_instances") != json_data.end()) {
-        json::array_t component_instances = json_data["component_instances"];
-        for (json::object_t json_object : component_instances) {
-            if (json_object.find("library_id") == json_object.end()) {
-                throw parse_exception("Component instance has no component library id!");
-            }
-            if (this->components[json_object["library_id"]] == nullptr) {
-                std::cerr<<"Component instance does not have a matching component definition, not adding!"<<std::endl;
+    std::exception_ptr error;
+    try {
+        graph.run();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (size_t index = 0; index < diagnostics.size(); index++) {
+        diagnostics[index]->replay();
+        if (graph.has_failed(index)) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void open_json::data::materialize(const std::string &section) {
+    std::map<std::string, std::unique_ptr<lazy_section>>::iterator lazy = this->lazy_sections.find(section);
+    if (lazy == this->lazy_sections.end()) {
+        return;
+    }
+    lazy_section &pending = *lazy->second;
+    std::call_once(pending.decoded, [this, &section, &pending]() {
+        for (const section_reader &reader : this->get_section_readers()) {
+            if (reader.name != section) {
+                continue;
             }
-            try {
-                std::shared_ptr<types::component_instance> componentInstance(new types::component_instance(dynamic_cast<types::json_object*>(this), this, this->components[json_object["library_id"]], json_object));
-                this->component_instances[componentInstance->get_id()] = componentInstance;
-            } catch (parse_exception e) {
-                std::cerr<<"Not adding component instance for reason:"<<e.what()<<std::endl;
+            for (const std::string &dependency : reader.dependencies) {
+                this->materialize(dependency);
             }
+            json section_json = scan::parse_value(*this->document, *this->document_index, pending.begin, pending.end);
+            this->read_section(reader, section_json, pending.account);
         }
-    }
-    
-    if (json_data.find("layer_options") != json_data.end()) {
-        for (json::object_t json_object : json_data["layer_options"]) {
-            this->layer_options.emplace_back(new types::layer_option(dynamic_cast<types::json_object*>(this), this, json_object));
+        // Nothing reads the text anymore once every section is decoded, a failed section stays pending and keeps it
+        if (--this->undecoded_sections == 0) {
+            this->document.reset();
+            this->document_index.reset();
         }
+    });
+}
+
+void open_json::data::materialize_all() {
+    for (auto &section : this->lazy_sections) {
+        this->materialize(section.first);
     }
-    
-    if (json_data.find("layout_bodies") != json_data.end()) {
-        for (json::object_t json_object : json_data["layout_bodies"]) {
-            this->layout_bodies.emplace_back(new types::body(dynamic_cast<types::json_object*>(this), this, json_object));
-        }
+}
+
+// The same parts show up in many designs, identical definitions are read once per process and shared
+void open_json::data::read_components(const json &components_json) {
+    library::component_cache &cache = library::component_cache::shared();
+    bool legacy_format = this->version_info.major < 1 && this->version_info.minor < 2;
+    for (json::const_iterator it = components_json.begin(); it != components_json.end(); it++) {
+        this->components[it.key()] = cache.get(it.key(), legacy_format, it.value(), [&]() {
+            return std::shared_ptr<types::component>(new types::component(dynamic_cast<types::json_object*>(this), this, it.value(), it.key()));
+        });
     }
-    
-    if (json_data.find("layout_body_attributes") != json_data.end()) {
-        for (json::object_t json_object : json_data["layout_body_attributes"]) {
-            this->layout_body_attributes.emplace_back(new types::layout_body_attribute(dynamic_cast<types::json_object*>(this), this, json_object));
+}
+
+void open_json::data::read_component_instances(const json &component_instances_json) {
+    for (json::object_t json_object : component_instances_json) {
+        if (json_object.find("library_id") == json_object.end()) {
+            throw parse_exception("Component instance has no component library id!");
         }
-    }
-    
-    if (json_data.find("layout_objects") != json_data.end()) {
-        json::array_t layout_objects = json_data["layout_objects"];
-        for (json::object_t json_object : layout_objects) {
-            this->layout_objects.emplace_back(new types::layout_object(dynamic_cast<types::json_object*>(this), this, json_object));
+        auto definition = this->components.find(json_object["library_id"]);
+        if (definition == this->components.end()) {
+            error_stream()<<"Component instance does not have a matching component definition, not adding!"<<std::endl;
+            continue;
         }
-    }
-    
-    if (json_data.find("nets") != json_data.end()) {
-        for (json::object_t json_object : json_data["nets"]) {
-            if (json_object.find("net_id") == json_object.end()) {
-                throw parse_exception("Net has no net id!");
-            }
-            std::shared_ptr<types::net> net(new types::net(dynamic_cast<types::json_object*>(this), this));
-            try {
-                if (net->try_read(json_object)) {
-                    this->nets[net->get_id()] = net;
-                    continue;
-                }
-            } catch (parse_exception e) {
-                std::cerr<<"Invalid net found! Skipping net:"<<net->get_id()<<" Reason: "<<e.what()<<std::endl;
-                continue;
-            }
-            std::cerr<<"Invalid net found! Skipping net:"<<net->get_id()<<std::endl;
+        try {
+            std::shared_ptr<types::component_instance> componentInstance(new types::component_instance(dynamic_cast<types::json_object*>(this), this, definition->second, json_object));
+            this->component_instances[componentInstance->get_id()] = componentInstance;
+        } catch (parse_exception e) {
+            error_stream()<<"Not adding component instance for reason:"<<e.what()<<std::endl;
         }
     }
-    
-    if (json_data.find("pcb_text") != json_data.end()) {
-        for (json::object_t json_object : json_data["pcb_text"]) {
-            this->pcb_text.emplace_back(new types::pcb_text(dynamic_cast<types::json_object*>(this), this, json_object));
+}
+
+// Nets only read the finished component instance map, each one is parsed and validated on the shared pool.
+// Results and diagnostics are merged back in input order so the outcome doesn't depend on scheduling.
+void open_json::data::read_nets(const json &nets_json) {
+    typedef struct net_result {
+        std::shared_ptr<types::net> net;
+        bool has_id = false, accepted = false;
+        diagnostic_capture diagnostics;
+    } net_result;
+    
+    // Nets may also come as an object keyed by id, like the range-for before it every value is read
+    std::vector<json::const_iterator> elements;
+    elements.reserve(nets_json.size());
+    for (json::const_iterator it = nets_json.begin(); it != nets_json.end(); it++) {
+        elements.push_back(it);
+    }
+    std::vector<net_result> results(elements.size());
+    accounting::account *account = accounting::current_account();
+    parallel::for_each_index(elements.size(), [&](size_t index) {
+        accounting::account_scope charged(account);
+        net_result &result = results[index];
+        json::object_t json_object = *elements[index];
+        result.has_id = json_object.find("net_id") != json_object.end();
+        if (!result.has_id) {
+            return;
         }
-    }
-    
-    if (json_data.find("pours") != json_data.end()) {
-        for (json::object_t json_object : json_data["pours"]) {
-            this->pours.emplace_back(new types::pour(dynamic_cast<types::json_object*>(this), this, json_object));
+        diagnostic_capture::scope capture(result.diagnostics);
+        result.net = std::shared_ptr<types::net>(new types::net(dynamic_cast<types::json_object*>(this), this));
+        try {
+            if (result.net->try_read(json_object)) {
+                result.accepted = true;
+                return;
+            }
+        } catch (const parse_exception &e) {
+            error_stream()<<"Invalid net found! Skipping net:"<<result.net->get_id()<<" Reason: "<<e.what()<<std::endl;
+            return;
         }
-    }
+        error_stream()<<"Invalid net found! Skipping net:"<<result.net->get_id()<<std::endl;
+    });
     
-    if (json_data.find("trace_segments") != json_data.end()) {
-        for (json::object_t json_object : json_data["trace_segments"]) {
-            this->traces.emplace_back(new types::trace(dynamic_cast<types::json_object*>(this), this, json_object));
+    for (net_result &result : results) {
+        if (!result.has_id) {
+            throw parse_exception("Net has no net id!");
         }
-    }
-    
-    if (json_data.find("paths") != json_data.end()) {
-        for (json::object_t json_object : json_data["paths"]) {
-            this->paths.emplace_back(new types::path(dynamic_cast<types::json_object*>(this), this, json_object));
+        result.diagnostics.replay();
+        if (result.accepted) {
+            this->nets[result.net->get_id()] = result.net;
         }
     }
 }
 
 json::object_t open_json::data::get_json() {
-    json data = {
-        {"component_instances", json::value_t::array},
-        {"components", json::value_t::object},
-        {"design_attributes", json::value_t::object},
-        {"layer_options", json::value_t::array},
-        {"layout_bodies", json::value_t::array},
-        {"layout_body_attributes", json::value_t::array},
-        {"layout_objects", json::value_t::array},
-        {"nets", json::value_t::array},
-        {"pcb_text", json::value_t::array},
-        {"pours", json::value_t::array},
-        {"trace_segments", json::value_t::array},
-        {"paths", json::value_t::array},
-        {"version", { // TODO Move this constant to a const/possibly a cli option to change name
-            {"exporter", "EDA Converter"}, 
-            {"file_version", "0.2.0"} // We export the 0.2.0 version, TODO move this to a const
-        }}
+    json data(json::value_t::object);
+    for (json_section &section : this->get_json_sections()) {
+        if (section.is_array) {
+            data[section.key] = json::value_t::array;
+            for (size_t index = 0; index < section.count; index++) {
+                data[section.key].push_back(section.get_value(index));
+            }
+        } else {
+            data[section.key] = section.get_value(0);
+        }
+    }
+    return data;
+}
+
+std::vector<open_json::data::json_section> open_json::data::get_json_sections(output_type type, const std::set<std::string> &only_sections) {
+    auto is_wanted = [type, &only_sections](const std::string &key) { return is_section_needed(key, type, only_sections); };
+    for (const section_info &section : get_section_table()) {
+        if (is_wanted(section.key)) {
+            this->materialize(section.key);
+        }
+    }
+    auto value_section = [](const std::string &key, std::function<json()> get_value) {
+        json_section section;
+        section.key = key;
+        section.get_value = [get_value](size_t) { return get_value(); };
+        return section;
+    };
+    auto array_section = [](const std::string &key, size_t count, std::function<json(size_t)> get_value) {
+        json_section section;
+        section.key = key;
+        section.is_array = true;
+        section.count = count;
+        section.get_value = get_value;
+        return section;
     };
     
-    for (auto component_instance : this->component_instances) {
-        data["component_instances"].push_back(component_instance.second->get_json());
-        // Only write out the component definitions we need!
-        data["components"][component_instance.second->get_definition()->get_library_id()] = component_instance.second->get_definition()->get_json();
+    std::shared_ptr<std::vector<types::component_instance*>> instances = std::make_shared<std::vector<types::component_instance*>>();
+    for (auto &component_instance : this->component_instances) {
+        instances->push_back(component_instance.second.get());
     }
     
-    // for (auto component : this->components) {
-    //     data["components"][component.first] = component.second->get_json();
-    // }
-    
-    if (this->design_info.get() != nullptr) {
-        data["design_attributes"] = this->design_info->get_json();
+    // The other half of the design isn't traversed at all
+    std::vector<json_section> sections;
+    if (is_wanted("component_instances")) {
+        sections.push_back(array_section("component_instances", instances->size(), [instances, type](size_t index) -> json { return (*instances)[index]->get_json(type); }));
     }
-    
-    for (auto layer_option : this->layer_options) {
-        data["layer_option"].push_back(layer_option->get_json());
+    if (is_wanted("components")) {
+        bool has_instances = is_wanted("component_instances");
+        sections.push_back(value_section("components", [this, instances, has_instances, type]() {
+            // Only write out the component definitions we need! Without the instances every definition is needed
+            std::map<std::string, types::component*> definitions;
+            if (has_instances) {
+                for (types::component_instance *component_instance : *instances) {
+                    definitions[component_instance->get_definition()->get_library_id()] = component_instance->get_definition().get();
+                }
+            } else {
+                for (auto &component : this->components) {
+                    definitions[component.second->get_library_id()] = component.second.get();
+                }
+            }
+            json components(json::value_t::object);
+            for (auto &definition : definitions) {
+                components[definition.first] = definition.second->get_json(type);
+            }
+            return components;
+        }));
     }
-    
-    for (auto layout_body : this->layout_bodies) {
-        data["layout_bodies"].push_back(layout_body->get_json());
+    sections.push_back(value_section("design_attributes", [this]() -> json { return this->design_info.get() != nullptr ? json(this->design_info->get_json()) : json(json::value_t::object); }));
+    if (is_wanted("layer_options")) {
+        // The layer options have always been written under the singular key, the plural one stays empty
+        sections.push_back(value_section("layer_options", []() { return json(json::value_t::array); }));
+        if (!this->layer_options.empty()) {
+            sections.push_back(array_section("layer_option", this->layer_options.size(), [this](size_t index) -> json { return this->layer_options[index]->get_json(); }));
+        }
     }
-    
-    for (auto layout_body_attribute : this->layout_body_attributes) {
-        data["layout_body_attributes"].push_back(layout_body_attribute->get_json());
+    if (is_wanted("layout_bodies")) {
+        sections.push_back(array_section("layout_bodies", this->layout_bodies.size(), [this](size_t index) -> json { return this->layout_bodies[index]->get_json(); }));
     }
-    
-    for (auto layout_object : this->layout_objects) {
-        data["layout_objects"].push_back(layout_object->get_json());
+    if (is_wanted("layout_body_attributes")) {
+        sections.push_back(array_section("layout_body_attributes", this->layout_body_attributes.size(), [this](size_t index) -> json { return this->layout_body_attributes[index]->get_json(); }));
     }
-    
-    for (auto net : this->nets) {
-        data["nets"].push_back(net.second->get_json());
+    if (is_wanted("layout_objects")) {
+        sections.push_back(array_section("layout_objects", this->layout_objects.size(), [this](size_t index) -> json { return this->layout_objects[index]->get_json(); }));
     }
-    
-    for (auto pcb_text_object : this->pcb_text) {
-        data["pcb_text"].push_back(pcb_text_object->get_json());
+    if (is_wanted("nets")) {
+        std::shared_ptr<std::vector<types::net*>> design_nets = std::make_shared<std::vector<types::net*>>();
+        for (auto &net : this->nets) {
+            design_nets->push_back(net.second.get());
+        }
+        sections.push_back(array_section("nets", design_nets->size(), [design_nets](size_t index) -> json { return (*design_nets)[index]->get_json(); }));
     }
-    
-    for (auto pour : this->pours) {
-        data["pours"].push_back(pour->get_json());
+    if (is_wanted("pcb_text")) {
+        sections.push_back(array_section("pcb_text", this->pcb_text.size(), [this](size_t index) -> json { return this->pcb_text[index]->get_json(); }));
     }
-    
-    for (auto trace : this->traces) {
-        data["trace_segments"].push_back(trace->get_json());
+    if (is_wanted("pours")) {
+        sections.push_back(array_section("pours", this->pours.size(), [this](size_t index) -> json { return this->pours[index]->get_json(); }));
     }
-        
-    for (auto path : this->paths) {
-        data["paths"].push_back(path->get_json());
+    if (is_wanted("trace_segments")) {
+        sections.push_back(array_section("trace_segments", this->traces.size(), [this](size_t index) -> json { return this->traces[index]->get_json(); }));
     }
-    
-    return data;
+    if (is_wanted("paths")) {
+        sections.push_back(array_section("paths", this->paths.size(), [this](size_t index) -> json { return this->paths[index]->get_json(); }));
+    }
+    sections.push_back(value_section("version", []() -> json {
+        return { // TODO Move this constant to a const/possibly a cli option to change name
+            {"exporter", "EDA Converter"},
+            {"file_version", "0.2.0"} // We export the 0.2.0 version, TODO move this to a const
+        };
+    }));
+    return sections;
+}
+
+std::shared_ptr<open_json::spatial::spatial_index> open_json::data::get_spatial_index() {
+    std::call_once(this->spatial_index_flag, [this]() {
+        this->materialize_all();
+        this->spatial_index = std::make_shared<spatial::spatial_index>(*this);
+    });
+    return this->spatial_index;
+}
+
+std::shared_ptr<open_json::bounds::extents> open_json::data::get_extents() {
+    std::call_once(this->extents_flag, [this]() {
+        this->materialize_all();
+        this->extents = bounds::compute_extents(*this);
+    });
+    return this->extents;
+}
+
+std::shared_ptr<open_json::transform::world_geometry> open_json::data::get_world_geometry() {
+    std::call_once(this->world_geometry_flag, [this]() {
+        this->materialize_all();
+        this->world_geometry = transform::place_instances(*this);
+    });
+    return this->world_geometry;
+}
+
+std::shared_ptr<open_json::connectivity::net_graph> open_json::data::get_connectivity() {
+    std::call_once(this->connectivity_flag, [this]() {
+        this->materialize_all();
+        std::vector<types::net *> design_nets;
+        for (auto &net : this->nets) {
+            design_nets.push_back(net.second.get());
+        }
+        this->connectivity = std::make_shared<connectivity::net_graph>(this, design_nets);
+    });
+    return this->connectivity;
 }
 
 // Design Info
@@ -293,7 +668,7 @@ json::object_t open_json::types::design_info::get_json() {
 
 // Component
 void open_json::types::component::read(json json_data) {
-    this->name = open_json::get_value_or_default<std::string>(json_data, "name", "Unamed");
+    this->name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "name", "Unamed"));
     
     if (json_data.find("attributes") != json_data.end()) {
         types::populate_attributes(this->attributes, json_data["attributes"]);
@@ -312,25 +687,29 @@ void open_json::types::component::read(json json_data) {
     }
 }
 
-json::object_t open_json::types::component::get_json() {
+json::object_t open_json::types::component::get_json(output_type type) {
     json data {
         {"attributes", this->attributes},
-        {"footprints", json::value_t::array},
-        {"name", this->name},
-        {"symbols", json::value_t::array}
+        {"name", to_json(this->name)}
     };
-    for (auto f : this->footprints) {
-        data["footprints"].push_back(f.get_json());
+    if (type != output_type::SCHEMATIC) {
+        data["footprints"] = json::value_t::array;
+        for (auto f : this->footprints) {
+            data["footprints"].push_back(f.get_json());
+        }
     }
-    for (auto s : this->symbols) {
-        data["symbols"].push_back(s->get_json());
+    if (type != output_type::LAYOUT) {
+        data["symbols"] = json::value_t::array;
+        for (auto s : this->symbols) {
+            data["symbols"].push_back(s->get_json());
+        }
     }
     return data;
 }
 
 // Component Instance
 void open_json::types::component_instance::read(json json_data) {
-    this->instance_id = open_json::get_value_or_default<std::string>(json_data, "instance_id", "0000000000000000");
+    this->instance_id = to_tracked(open_json::get_value_or_default<std::string>(json_data, "instance_id", "0000000000000000"));
     this->symbol_index = open_json::get_value_or_default(json_data, "symbol_index", this->symbol_index);
     this->footprint_index = open_json::get_value_or_default(json_data, "footprint_index", this->footprint_index);
     
@@ -365,34 +744,38 @@ void open_json::types::component_instance::read(json json_data) {
     }
 }
 
-json::object_t open_json::types::component_instance::get_json() {
+json::object_t open_json::types::component_instance::get_json(output_type type) {
     json data = {
         {"attributes", this->attributes},
-        {"footprint_attributes", json::value_t::array},
-        {"footprint_index", this->footprint_index},
-        {"footprint_pos", {
+        {"instance_id", to_json(this->instance_id)},
+        {"library_id", this->component_def->get_library_id()}
+    };
+    
+    // Generated objects belong to the footprints
+    if (type != output_type::SCHEMATIC) {
+        data["footprint_attributes"] = json::value_t::array;
+        data["footprint_index"] = this->footprint_index;
+        data["footprint_pos"] = {
             {"flip", this->footprint_pos.flip},
             {"rotation", this->footprint_pos.rotation},
             {"side", this->footprint_pos.side},
             {"x", this->footprint_pos.position.x},
-            {"y", this->footprint_pos.position.y}}},
-        {"gen_obj_attributes", json::value_t::array},
-        {"instance_id", this->instance_id},
-        {"library_id", this->component_def->get_library_id()},
-        {"symbol_attributes", json::value_t::array},
-        {"symbol_index", this->symbol_index}
-    };
-    
-    for (auto f : this->footprint_attributes) {
-        data["footprint_attributes"].push_back(f.get_json());
-    }
-    
-    for (auto o : this->generated_object_attributes) {
-        data["gen_obj_attributes"].push_back(o.get_json());
+            {"y", this->footprint_pos.position.y}};
+        data["gen_obj_attributes"] = json::value_t::array;
+        for (auto f : this->footprint_attributes) {
+            data["footprint_attributes"].push_back(f.get_json());
+        }
+        for (auto o : this->generated_object_attributes) {
+            data["gen_obj_attributes"].push_back(o.get_json());
+        }
     }
     
-    for (auto s : this->symbol_attributes) {
-        data["symbol_attributes"].push_back(s.get_json());
+    if (type != output_type::LAYOUT) {
+        data["symbol_attributes"] = json::value_t::array;
+        data["symbol_index"] = this->symbol_index;
+        for (auto s : this->symbol_attributes) {
+            data["symbol_attributes"].push_back(s.get_json());
+        }
     }
     
     return data;
@@ -436,7 +819,7 @@ void open_json::types::footprint_attribute::read(json json_data) {
         if (json_data["layer"].is_null()) {
             throw parse_exception("Layer name is null! Most likely this is from a ghost component instance!");
         }
-        this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+        this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     } catch (std::exception e) {
         throw parse_exception(std::string("Error parsing layer name! Exception: ").append(e.what()));
     }
@@ -446,7 +829,7 @@ json::object_t open_json::types::footprint_attribute::get_json() {
     return {
         {"flip", this->flip},
         {"rotation", this->rotation},
-        {"layer", this->layer_name},
+        {"layer", to_json(this->layer_name)},
         {"x", this->position.x},
         {"y", this->position.y}
     };
@@ -508,7 +891,7 @@ void open_json::types::body::read(json json_data) {
     this->flip = open_json::get_boolean(json_data["flip"]);
     this->moveable = open_json::get_boolean(json_data["moveable"], true);
     this->removeable = open_json::get_boolean(json_data["removeable"], true);
-    this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+    this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     
     if (json_data.find("connection_indexes") != json_data.end()) {
         for (int connection : json_data["connection_indexes"]) {
@@ -565,7 +948,7 @@ json::object_t open_json::types::body::get_json() {
         {"flip", this->flip},
         {"moveable", this->moveable},
         {"removeable", this->removeable},
-        {"layer", this->layer_name}
+        {"layer", to_json(this->layer_name)}
     };
     
     for (auto a : this->annotations) {
@@ -587,6 +970,14 @@ json::object_t open_json::types::body::get_json() {
     return data;
 }
 
+open_json::types::bounding_box open_json::types::body::get_bounds() {
+    bounding_box bounds;
+    for (auto s : this->shapes) {
+        bounds.expand(s->get_bounds());
+    }
+    return bounds;
+}
+
 // Generated Object
 void open_json::types::generated_object::read(json json_data) {
     if (json_data.find("connection_indexes") != json_data.end()) {
@@ -616,7 +1007,7 @@ void open_json::types::generated_object_attribute::read(json json_data) {
         if (json_data["layer"].is_null()) {
             throw parse_exception("Layer name is null! Most likely this is from a ghost component instance!");
         }
-        this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+        this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     } catch (std::exception e) {
         throw parse_exception(std::string("Error parsing layer name! Exception: ").append(e.what()));
     }
@@ -630,7 +1021,7 @@ json::object_t open_json::types::generated_object_attribute::get_json() {
     return {
         {"attributes", this->attributes},
         {"flip", this->flip},
-        {"layer", this->layer_name},
+        {"layer", to_json(this->layer_name)},
         {"rotation", this->rotation},
         {"x", this->position.x},
         {"y", this->position.y}
@@ -640,17 +1031,17 @@ json::object_t open_json::types::generated_object_attribute::get_json() {
 void open_json::types::action_region::read(json json_data) {
     if (this->file_data->version_info.major < 1 && this->file_data->version_info.minor < 2) {
         // Pins to Action Region
-        this->ref_id = this->name = open_json::get_value_or_default<std::string>(json_data, "pin_number", "0");
+        this->ref_id = this->name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "pin_number", "0"));
         // Move label to shapes
         if (json_data.find("label") != json_data.end()) {
             // Apparently you cannot count on the label object having the "type" field
             dynamic_cast<types::body*>(this->parent)->add_shape(open_json::types::shapes::shape::new_shape(open_json::types::shapes::shape_type::LABEL, this->parent, this->file_data, json_data["label"]));
             // Set the name to the label text, or if for some reason it doesn't exist use the pin_number text
-            this->name = open_json::get_value_or_default(json_data["label"], "text", this->name);
+            this->name = to_tracked(open_json::get_value_or_default(json_data["label"], "text", to_string(this->name)));
         }
     } else {
-        this->name = open_json::get_value_or_default<std::string>(json_data, "name", "Unnamed Region");
-        this->ref_id = open_json::get_value_or_default(json_data, "ref", this->name);
+        this->name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "name", "Unnamed Region"));
+        this->ref_id = to_tracked(open_json::get_value_or_default(json_data, "ref", to_string(this->name)));
     }
 
     if (json_data.find("attributes") != json_data.end()) {
@@ -681,14 +1072,14 @@ json::object_t open_json::types::action_region::get_json() {
     return {
         {"attributes", this->attributes},
         {"connections", this->connections},
-        {"name", this->name},
+        {"name", to_json(this->name)},
         {"p1", {
             {"x", this->p1.x},
             {"y", this->p1.y}}},
         {"p2", {
             {"x", this->p2.x},
             {"y", this->p2.y}}},
-        {"ref", this->ref_id},
+        {"ref", to_json(this->ref_id)},
         {"styles", this->styles}
     };
 }
@@ -723,23 +1114,23 @@ json::object_t open_json::types::annotation::get_json() {
 
 // Layer Option
 void open_json::types::layer_option::read(json json_data) {
-    this->ident = open_json::get_value_or_default(json_data, "ident", open_json::get_value_or_default<std::string>(json_data, "name", "Unnamed"));
-    this->name = open_json::get_value_or_default(json_data, "name", this->ident);
+    this->ident = to_tracked(open_json::get_value_or_default(json_data, "ident", open_json::get_value_or_default<std::string>(json_data, "name", "Unnamed")));
+    this->name = to_tracked(open_json::get_value_or_default(json_data, "name", to_string(this->ident)));
     this->is_copper = open_json::get_boolean(json_data["is_copper"], true);
 }
 
 json::object_t open_json::types::layer_option::get_json() {
     return {
-        {"ident", this->ident},
+        {"ident", to_json(this->ident)},
         {"is_copper", this->is_copper},
-        {"name", this->name}
+        {"name", to_json(this->name)}
     };
 }
 
 // Layout Object Attribute
 void open_json::types::layout_body_attribute::read(json json_data) {
     this->flip = open_json::get_boolean(json_data["flip"]);
-    this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+    this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     this->rotation = open_json::get_value_or_default(json_data, "rotation", this->rotation);
     this->position = open_json::types::point(open_json::get_value_or_default(json_data, "x", this->position.x), open_json::get_value_or_default(json_data, "y", this->position.y));
 }
@@ -747,7 +1138,7 @@ void open_json::types::layout_body_attribute::read(json json_data) {
 json::object_t open_json::types::layout_body_attribute::get_json() {
     return {
         {"flip", this->flip},
-        {"layer", this->layer_name},
+        {"layer", to_json(this->layer_name)},
         {"rotation", this->rotation},
         {"x", this->position.x},
         {"y", this->position.y}
@@ -783,7 +1174,7 @@ json::object_t open_json::types::layout_object::get_json() {
 void open_json::types::pcb_text::read(json json_data) {
     this->flip = open_json::get_boolean(json_data["flip"]);
     this->visible = open_json::get_boolean(json_data["visible"], true);
-    this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+    this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     this->rotation = open_json::get_value_or_default(json_data, "rotation", this->rotation);
     this->position = open_json::types::point(open_json::get_value_or_default(json_data, "x", this->position.x), open_json::get_value_or_default(json_data, "y", this->position.y));
     
@@ -795,7 +1186,7 @@ void open_json::types::pcb_text::read(json json_data) {
 json::object_t open_json::types::pcb_text::get_json() {
     json data = {
         {"flip", this->flip},
-        {"layer", this->layer_name},
+        {"layer", to_json(this->layer_name)},
         {"rotation", this->rotation},
         {"value", (this->label.get() != nullptr) ? this->label->get_text() : ""},
         {"visible", this->visible},
@@ -809,10 +1200,17 @@ json::object_t open_json::types::pcb_text::get_json() {
     return data;
 }
 
+open_json::types::bounding_box open_json::types::pcb_text::get_bounds() {
+    // The label is drawn relative to the text position, without font metrics the anchor point is all we can offer
+    bounding_box bounds;
+    bounds.expand(this->position);
+    return bounds;
+}
+
 // Pour
 void open_json::types::pour::read(json json_data) {
-    this->attached_net_id = open_json::get_value_or_default<std::string>(json_data, "attached_net", "Unnamed");
-    this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+    this->attached_net_id = to_tracked(open_json::get_value_or_default<std::string>(json_data, "attached_net", "Unnamed"));
+    this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     this->order_index = open_json::get_value_or_default(json_data, "order", this->order_index);
     
     if (json_data.find("attributes") != json_data.end()) {
@@ -837,7 +1235,7 @@ void open_json::types::pour::read(json json_data) {
             throw parse_exception("Invalid polygon in pour! No polygon type specified!");
         }
         if (open_json::types::shapes::shape_typename_registry.find(json_data["polygons"]["type"]) == open_json::types::shapes::shape_typename_registry.end()) {
-            std::cerr<<"WARNING: Unknown shape type:"<<json_data["polygons"]["type"]<<" found in pour. Omitting polygons!"<<std::endl;
+            open_json::error_stream()<<"WARNING: Unknown shape type:"<<json_data["polygons"]["type"]<<" found in pour. Omitting polygons!"<<std::endl;
         } else {
             this->pour_shape = open_json::types::shapes::shape::new_shape(open_json::types::shapes::shape_typename_registry[json_data["polygons"]["type"]], dynamic_cast<types::json_object*>(this), this->file_data, json_data["polygons"]);
         }
@@ -846,9 +1244,9 @@ void open_json::types::pour::read(json json_data) {
 
 json::object_t open_json::types::pour::get_json() {
     json data = {
-        {"attached_net", this->attached_net_id},
+        {"attached_net", to_json(this->attached_net_id)},
         {"attributes", this->attributes},
-        {"layer", this->layer_name},
+        {"layer", to_json(this->layer_name)},
         {"order", this->order_index},
         {"points", json::value_t::array},
         {"shape_types", json::value_t::array}
@@ -868,9 +1266,17 @@ json::object_t open_json::types::pour::get_json() {
     return data;
 }
 
+open_json::types::bounding_box open_json::types::pour::get_bounds() {
+    bounding_box bounds = open_json::bounds::reduce(this->points);
+    if (this->pour_shape.get() != nullptr) {
+        bounds.expand(this->pour_shape->get_bounds());
+    }
+    return bounds;
+}
+
 // Trace
 void open_json::types::trace::read(json json_data) {
-    this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+    this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     this->width = open_json::get_value_or_default(json_data, "width", 254000.0);
 
     if (json_data.find("p1") != json_data.end()) {
@@ -898,7 +1304,7 @@ void open_json::types::trace::read(json json_data) {
 json::object_t open_json::types::trace::get_json() {
     json data = {
         {"control_points", json::value_t::array},
-        {"layer", this->layer_name},
+        {"layer", to_json(this->layer_name)},
         {"p1", {
             {"x", this->start.x},
             {"y", this->start.y}
@@ -927,9 +1333,17 @@ json::object_t open_json::types::trace::get_json() {
     return data;
 }
 
+open_json::types::bounding_box open_json::types::trace::get_bounds() {
+    bounding_box bounds = open_json::bounds::reduce(this->control_points);
+    bounds.expand(this->start);
+    bounds.expand(this->end);
+    bounds.inflate(static_cast<int64_t>(this->width / 2.0));
+    return bounds;
+}
+
 // Net
 bool open_json::types::net::try_read(json json_data) {
-    this->net_id = open_json::get_value_or_default<std::string>(json_data, "net_id", "0000000000000000");
+    this->net_id = to_tracked(open_json::get_value_or_default<std::string>(json_data, "net_id", "0000000000000000"));
     
     if (json_data.find("net_type") != json_data.end()) {
         if (json_data["net_type"] == "nets") {
@@ -954,39 +1368,45 @@ bool open_json::types::net::try_read(json json_data) {
         bool check_for_inconsistencies = false;
         for (json::object_t net_object : json_data["points"]) {
             if (net_object.find("point_id") == net_object.end()) {
-                throw parse_exception("Invalid point in net: " + this->net_id + "! Point does not contain a point id!");
+                throw parse_exception("Invalid point in net: " + to_string(this->net_id) + "! Point does not contain a point id!");
             }
             auto point = std::shared_ptr<net_point>(new net_point(dynamic_cast<types::json_object*>(this), this->file_data, net_object["point_id"]));
-            if (!point->try_read(net_object)) {
-                // Adding point failed for some reason check for any inconsistencies.
+            if (point->try_read(net_object)) {
+                this->points[point->get_id()] = point;
+            } else {
+                // Adding point failed for some reason, drop it and check the rest for any inconsistencies.
                 check_for_inconsistencies = true;
             }
         }
-        // Check data
+        // Check data, only nets that lost points are graphed here. The dangling references of every other net are in the
+        // design wide graph, see data::get_connectivity
         if (check_for_inconsistencies) {
-            std::cout<<"Potentially inconsistent net: "<<this->net_id<<" checking consistency"<<std::endl;
-            for (auto point : this->points) {
-                for (auto action_region_iterator = point.second->get_begining_of_connected_regions(); action_region_iterator < point.second->get_end_of_connected_regions(); action_region_iterator++) {
-                    if (this->file_data->component_instances.find(action_region_iterator->component_instance_id) == this->file_data->component_instances.end()) {
-                        // Inconsistency found, tell caller to not add this net!
-                        std::cerr<<"Inconsistency in action regions for net: "<<this->net_id<<" invalid component instance id, skipping net!"<<std::endl;
-                        return false;
-                    }
-                }
-                for (std::string id : point.second->get_connected_point_ids()) {
-                    if (this->points.find(id) == this->points.end()) {
-                        std::cerr<<"Inconsistency in connected points for net: "<<this->net_id<<" no such point with id: "<<id<<", skipping net!"<<std::endl;
-                        return false;
-                    }
-                }
+            static instrument::metric &check_timing = instrument::get_metric("net.check");
+            instrument::scoped_timer timer(check_timing, to_string(this->net_id));
+            static instrument::metric &repairs = instrument::get_metric("net.repair");
+            repairs.add(1);
+            connectivity::net_graph graph(this->file_data, std::vector<net*>(1, this));
+            const connectivity::net_report &report = graph.get_reports().front();
+            open_json::message_stream()<<"Potentially inconsistent net: "<<this->net_id<<" checking consistency"<<std::endl;
+            if (!report.dangling_instance_ids.empty()) {
+                // Inconsistency found, tell caller to not add this net!
+                open_json::error_stream()<<"Inconsistency in action regions for net: "<<this->net_id<<" invalid component instance id, skipping net!"<<std::endl;
+                return false;
+            }
+            if (!report.dangling_point_ids.empty()) {
+                open_json::error_stream()<<"Inconsistency in connected points for net: "<<this->net_id<<" no such point with id: "<<report.dangling_point_ids.front()<<", skipping net!"<<std::endl;
+                return false;
+            }
+            open_json::message_stream()<<"The net: "<<this->net_id<<" seems consistent and repaired. Double check the net though maunually!"<<std::endl;
+            if (report.subnet_count > 1) {
+                open_json::message_stream()<<"The repaired net: "<<this->net_id<<" is split into "<<report.subnet_count<<" disconnected pieces!"<<std::endl;
             }
-            std::cout<<"The net: "<<this->net_id<<" seems consistent and repaired. Double check the net though maunually!"<<std::endl;
         }
     }
     
     if (json_data.find("signals") != json_data.end()) {
         for (std::string signal_name : json_data["signals"]) {
-            this->signals.push_back(signal_name);
+            this->signals.push_back(to_tracked(signal_name));
         }
     }
     
@@ -997,9 +1417,9 @@ json::object_t open_json::types::net::get_json() {
     json out = {
         {"annotations", json::value_t::array},
         {"attributes", this->attributes},
-        {"net_id", this->net_id},
+        {"net_id", to_json(this->net_id)},
         {"points", json::value_t::array},
-        {"signals", this->signals}
+        {"signals", to_json(this->signals)}
     };
     
     for (auto a : this->annotations) {
@@ -1028,7 +1448,7 @@ bool open_json::types::net_point::try_read(json json_data) {
     this->position = open_json::types::point(open_json::get_value_or_default(json_data, "x", this->position.x), open_json::get_value_or_default(json_data, "y", this->position.y));
     
     for (std::string point_id : json_data["connected_points"]) {
-        this->connected_point_ids.push_back(point_id);
+        this->connected_point_ids.push_back(to_tracked(point_id));
     }
     
     // Wont be found in versions less than 0.2.0
@@ -1036,9 +1456,9 @@ bool open_json::types::net_point::try_read(json json_data) {
         for (json connected_action_region : json_data["connected_action_regions"]) {
             std::string component_instance = open_json::get_value_or_default<std::string>(connected_action_region, "instance_id", "0000000000000000");
             // Consistency check
-            if (this->file_data->component_instances.find(component_instance) ==  this->file_data->component_instances.end()) {
+            if (this->file_data->get_component_instances().find(component_instance) == this->file_data->get_component_instances().end()) {
                 // Refers to invalid component instance!
-                std::cerr<<"Error in connected action region for net_point:"<<this->point_id<<"! Invalid instance_id!"<<std::endl;
+                open_json::error_stream()<<"Error in connected action region for net_point:"<<this->point_id<<"! Invalid instance_id!"<<std::endl;
                 return false;
             }
             this->connected_action_regions.emplace_back(
@@ -1053,20 +1473,24 @@ bool open_json::types::net_point::try_read(json json_data) {
     
     // Only in file versions less than 0.2.0
     if (json_data.find("connected_components") != json_data.end()) {
+        static instrument::metric &upgrade_timing = instrument::get_metric("net.upgrade");
+        instrument::scoped_timer timer(upgrade_timing, to_string(this->point_id));
+        upgrade_timing.add(json_data["connected_components"].size());
         for (json connected_component : json_data["connected_components"]) {
             if (connected_component.find("instance_id") == connected_component.end()) {
-                std::cerr<<"Error in connected action region for net_point:"<<this->point_id<<"! A connected component does not have an instance id!"<<std::endl;
+                open_json::error_stream()<<"Error in connected action region for net_point:"<<this->point_id<<"! A connected component does not have an instance id!"<<std::endl;
                 return false;
             }
             if (connected_component.find("pin_number") == connected_component.end()) {
-                std::cerr<<"Error in connected action region for net_point:"<<this->point_id<<"! A connected component does not have a pin number!"<<std::endl;
+                open_json::error_stream()<<"Error in connected action region for net_point:"<<this->point_id<<"! A connected component does not have a pin number!"<<std::endl;
                 return false;
             }
-            if (this->file_data->component_instances.find(connected_component["instance_id"]) != this->file_data->component_instances.end()) {
-                std::shared_ptr<types::component_instance> component_instance = this->file_data->component_instances[connected_component["instance_id"]];
+            auto instance = this->file_data->get_component_instances().find(connected_component["instance_id"]);
+            if (instance != this->file_data->get_component_instances().end()) {
+                std::shared_ptr<types::component_instance> component_instance = instance->second;
                 std::shared_ptr<types::symbol> symbol = component_instance->get_definition()->get_symbol_at_index(component_instance->get_symbol_index());
                 if (!symbol) {
-                    std::cerr<<"Error in connected action region for net_point:"<<this->point_id<<"! Invalid symbol index!"<<std::endl;
+                    open_json::error_stream()<<"Error in connected action region for net_point:"<<this->point_id<<"! Invalid symbol index!"<<std::endl;
                     return false;
                 }
                 auto get_action_region_index = [&symbol, &connected_component](size_t body_index) -> std::pair<bool, size_t> {
@@ -1095,13 +1519,13 @@ bool open_json::types::net_point::try_read(json json_data) {
                     }
                 }
                 if (!conversion_successful) {
-                    std::cerr<<"Error converting a net point("<<this->point_id<<") to new format, couldn't find a matching pin number: "<<connected_component["pin_number"]<<std::endl;
-                    std::cerr<<"Make sure to check and repair and check the net with id:"<<dynamic_cast<types::net*>(this->parent)->get_id()<<"!"<<std::endl;
+                    open_json::error_stream()<<"Error converting a net point("<<this->point_id<<") to new format, couldn't find a matching pin number: "<<connected_component["pin_number"]<<std::endl;
+                    open_json::error_stream()<<"Make sure to check and repair and check the net with id:"<<dynamic_cast<types::net*>(this->parent)->get_id()<<"!"<<std::endl;
                     return false;
                 }
             } else {
-                std::cerr<<"Error converting a net point("<<this->point_id<<") to new format, couldn't find component instance with id: "<<connected_component["instance_id"]<<std::endl;
-                std::cerr<<"Make sure to check and repair and check the net with id:"<<dynamic_cast<types::net*>(this->parent)->get_id()<<"!"<<std::endl;
+                open_json::error_stream()<<"Error converting a net point("<<this->point_id<<") to new format, couldn't find component instance with id: "<<connected_component["instance_id"]<<std::endl;
+                open_json::error_stream()<<"Make sure to check and repair and check the net with id:"<<dynamic_cast<types::net*>(this->parent)->get_id()<<"!"<<std::endl;
                 return false;
             }
         }
@@ -1112,8 +1536,8 @@ bool open_json::types::net_point::try_read(json json_data) {
 json::object_t open_json::types::net_point::get_json() {
     json out = {
         {"connected_action_regions", json::value_t::array },
-        {"point_id", this->point_id},
-        {"connected_points", this->connected_point_ids},
+        {"point_id", to_json(this->point_id)},
+        {"connected_points", to_json(this->connected_point_ids)},
         {"x", this->position.x},
         {"y", this->position.y}
     };
@@ -1122,9 +1546,9 @@ json::object_t open_json::types::net_point::get_json() {
         out["connected_action_regions"].push_back(json({
             {"action_region_index", region.action_region_index},
             {"body_index", region.body_index},
-            {"instance_id", region.component_instance_id},
+            {"instance_id", to_json(region.component_instance_id)},
             {"order", region.order_index},
-            {"signal", region.signal_name}
+            {"signal", to_json(region.signal_name)}
         }));
     }
     
@@ -1134,7 +1558,7 @@ json::object_t open_json::types::net_point::get_json() {
 // Path
 
 void open_json::types::path::read(json json_data) {
-    this->layer_name = open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed");
+    this->layer_name = to_tracked(open_json::get_value_or_default<std::string>(json_data, "layer", "Unnamed"));
     this->is_closed = open_json::get_boolean(json_data["is_closed"], this->is_closed);
     this->width = open_json::get_value_or_default(json_data, "width", this->width);
     
@@ -1160,7 +1584,7 @@ json::object_t open_json::types::path::get_json() {
     json data = {
         {"attributes", this->attributes},
         {"is_closed", this->is_closed},
-        {"layer", this->layer_name},
+        {"layer", to_json(this->layer_name)},
         {"points", json::value_t::array},
         {"shape_types", json::value_t::array},
         {"width", this->width}
@@ -1176,6 +1600,12 @@ json::object_t open_json::types::path::get_json() {
     return data;
 }
 
+open_json::types::bounding_box open_json::types::path::get_bounds() {
+    bounding_box bounds = open_json::bounds::reduce(this->points);
+    bounds.inflate(static_cast<int64_t>(this->width / 2.0));
+    return bounds;
+}
+
 // Shapes
 // Shape
 void open_json::types::shapes::shape::read(json json_data) {
@@ -1214,6 +1644,20 @@ json::object_t open_json::types::shapes::rectangle::get_json() {
     return shape;
 }
 
+open_json::types::bounding_box open_json::types::shapes::rectangle::get_bounds() {
+    // x, y is the top left corner
+    bounding_box bounds(this->position.x, this->position.y, this->position.x + this->width, this->position.y - this->height);
+    bounds.inflate(this->line_width / 2);
+    return bounds;
+}
+
+void open_json::types::shapes::rectangle::get_vertices(std::vector<point> &vertices) {
+    vertices.emplace_back(this->position.x, this->position.y);
+    vertices.emplace_back(this->position.x + this->width, this->position.y);
+    vertices.emplace_back(this->position.x + this->width, this->position.y - this->height);
+    vertices.emplace_back(this->position.x, this->position.y - this->height);
+}
+
 // Rounded Rectangle
 void open_json::types::shapes::rounded_rectangle::read(json json_data) {
     this->radius = open_json::get_value_or_default(json_data, "radius", this->radius);
@@ -1247,6 +1691,52 @@ json::object_t open_json::types::shapes::arc::get_json() {
     return shape;
 }
 
+double open_json::types::shapes::arc::get_sweep_radians() {
+    const double full_circle = 2.0 * open_json::angle_to_radians(1.0);
+    double sweep = std::fmod(open_json::angle_to_radians(this->end_angle - this->start_angle), full_circle);
+    if (sweep < 0.0) {
+        sweep += full_circle;
+    }
+    if (this->is_clockwise) {
+        sweep -= full_circle;
+    }
+    if (sweep == 0.0 || std::abs(sweep) == full_circle) {
+        return this->is_clockwise ? -full_circle : full_circle;
+    }
+    return sweep;
+}
+
+open_json::types::bounding_box open_json::types::shapes::arc::get_bounds() {
+    // The end points plus every axis crossing within the sweep
+    const double quarter_turn = open_json::angle_to_radians(0.5);
+    double start = this->get_start_radians(), sweep = this->get_sweep_radians();
+    double min_x = std::cos(start), max_x = min_x, min_y = std::sin(start), max_y = min_y;
+    min_x = std::min(min_x, std::cos(start + sweep));
+    max_x = std::max(max_x, std::cos(start + sweep));
+    min_y = std::min(min_y, std::sin(start + sweep));
+    max_y = std::max(max_y, std::sin(start + sweep));
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        double offset = std::fmod(quadrant * quarter_turn - start, 4.0 * quarter_turn);
+        if (sweep < 0.0) {
+            offset = 4.0 * quarter_turn - offset;
+        }
+        offset = std::fmod(offset + 4.0 * quarter_turn, 4.0 * quarter_turn);
+        if (offset <= std::abs(sweep)) {
+            min_x = std::min(min_x, std::cos(quadrant * quarter_turn));
+            max_x = std::max(max_x, std::cos(quadrant * quarter_turn));
+            min_y = std::min(min_y, std::sin(quadrant * quarter_turn));
+            max_y = std::max(max_y, std::sin(quadrant * quarter_turn));
+        }
+    }
+    bounding_box bounds(
+        this->position.x + static_cast<int64_t>(std::floor(min_x * this->radius)),
+        this->position.y + static_cast<int64_t>(std::floor(min_y * this->radius)),
+        this->position.x + static_cast<int64_t>(std::ceil(max_x * this->radius)),
+        this->position.y + static_cast<int64_t>(std::ceil(max_y * this->radius)));
+    bounds.inflate(this->width / 2);
+    return bounds;
+}
+
 // Circle
 void open_json::types::shapes::circle::read(json json_data) {
     this->radius = open_json::get_value_or_default(json_data, "radius", this->radius);
@@ -1263,6 +1753,12 @@ json::object_t open_json::types::shapes::circle::get_json() {
     return shape;
 }
 
+open_json::types::bounding_box open_json::types::shapes::circle::get_bounds() {
+    bounding_box bounds(this->position.x - this->radius, this->position.y - this->radius, this->position.x + this->radius, this->position.y + this->radius);
+    bounds.inflate(this->line_width / 2);
+    return bounds;
+}
+
 // Label
 void open_json::types::shapes::label::read(json json_data) {
     // Default to sans serif
@@ -1329,6 +1825,12 @@ json::object_t open_json::types::shapes::label::get_json() {
     return shape;
 }
 
+open_json::types::bounding_box open_json::types::shapes::label::get_bounds() {
+    bounding_box bounds;
+    bounds.expand(this->position);
+    return bounds;
+}
+
 // Line
 void open_json::types::shapes::line::read(json json_data) {
     this->width = open_json::get_value_or_default(json_data, "width", this->width);
@@ -1352,6 +1854,12 @@ json::object_t open_json::types::shapes::line::get_json() {
     return shape;
 }
 
+open_json::types::bounding_box open_json::types::shapes::line::get_bounds() {
+    bounding_box bounds(this->start.x, this->start.y, this->end.x, this->end.y);
+    bounds.inflate(this->width / 2);
+    return bounds;
+}
+
 // Rounded Segment
 void open_json::types::shapes::rounded_segment::read(json json_data) {
     this->radius = open_json::get_value_or_default(json_data, "radius", this->radius);
@@ -1363,6 +1871,12 @@ json::object_t open_json::types::shapes::rounded_segment::get_json() {
     return line;
 }
 
+open_json::types::bounding_box open_json::types::shapes::rounded_segment::get_bounds() {
+    bounding_box bounds = line::get_bounds();
+    bounds.inflate(std::max(0, this->radius - static_cast<int>(this->width / 2)));
+    return bounds;
+}
+
 // Polygon
 void open_json::types::shapes::polygon::read(json json_data) {
     this->line_width = open_json::get_value_or_default(json_data, "line_width", this->line_width);
@@ -1391,12 +1905,18 @@ json::object_t open_json::types::shapes::polygon::get_json() {
     return shape;
 }
 
+open_json::types::bounding_box open_json::types::shapes::polygon::get_bounds() {
+    bounding_box bounds = open_json::bounds::reduce(this->points);
+    bounds.inflate(this->line_width / 2);
+    return bounds;
+}
+
 // General Polygon
 void open_json::types::shapes::general_polygon::read(json json_data) {
     if (json_data.find("holes") != json_data.end()) {
         for (json polygon : json_data["holes"]) {
             if (polygon.find("points") != polygon.end()) {
-                std::vector<point> polygon_vertices;
+                point_list polygon_vertices;
                 for (json::object_t point : polygon["points"]) {
                     if (point.find("x") != point.end() && point.find("y") != point.end()) {
                         polygon_vertices.push_back({point["x"], point["y"]});
@@ -1440,6 +1960,21 @@ json::object_t open_json::types::shapes::general_polygon::get_json() {
     return data;
 }
 
+open_json::types::bounding_box open_json::types::shapes::general_polygon::get_bounds() {
+    // Holes are always inside of the outline
+    bounding_box bounds = polygon::get_bounds();
+    bounds.expand(open_json::bounds::reduce(this->pour_outline.points));
+    return bounds;
+}
+
+void open_json::types::shapes::general_polygon::get_vertices(std::vector<point> &vertices) {
+    polygon::get_vertices(vertices);
+    vertices.insert(vertices.end(), this->pour_outline.points.begin(), this->pour_outline.points.end());
+    for (polygon_points &hole : this->holes) {
+        vertices.insert(vertices.end(), hole.points.begin(), hole.points.end());
+    }
+}
+
 // General Polygon Set
 void open_json::types::shapes::general_polygon_set::read(json json_data) {
     if (json_data.find("polygons") != json_data.end()) {
@@ -1464,6 +1999,21 @@ json::object_t open_json::types::shapes::general_polygon_set::get_json() {
     return data;
 }
 
+open_json::types::bounding_box open_json::types::shapes::general_polygon_set::get_bounds() {
+    bounding_box bounds = polygon::get_bounds();
+    for (auto sub_shape : this->sub_shapes) {
+        bounds.expand(sub_shape->get_bounds());
+    }
+    return bounds;
+}
+
+void open_json::types::shapes::general_polygon_set::get_vertices(std::vector<point> &vertices) {
+    polygon::get_vertices(vertices);
+    for (auto sub_shape : this->sub_shapes) {
+        sub_shape->get_vertices(vertices);
+    }
+}
+
 // Bezier Curve
 void open_json::types::shapes::bezier_curve::read(json json_data) {
     if (json_data.find("p1") != json_data.end()) {
@@ -1496,24 +2046,218 @@ json::object_t open_json::types::shapes::bezier_curve::get_json() {
     return shape;
 }
 
+open_json::types::bounding_box open_json::types::shapes::bezier_curve::get_bounds() {
+    // End points plus the extremes where the derivative of either axis is zero
+    bounding_box bounds;
+    bounds.expand(this->start);
+    bounds.expand(this->end);
+    auto evaluate = [](double p0, double p1, double p2, double p3, double t) {
+        double u = 1.0 - t;
+        return u * u * u * p0 + 3.0 * u * u * t * p1 + 3.0 * u * t * t * p2 + t * t * t * p3;
+    };
+    auto add_extremes = [&](int64_t p0, int64_t p1, int64_t p2, int64_t p3, int64_t &minimum, int64_t &maximum) {
+        double a = -static_cast<double>(p0) + 3.0 * p1 - 3.0 * p2 + p3;
+        double b = 2.0 * (static_cast<double>(p0) - 2.0 * p1 + p2);
+        double c = static_cast<double>(p1) - p0;
+        std::vector<double> roots;
+        if (std::abs(a) < 1e-12) {
+            if (std::abs(b) > 1e-12) {
+                roots.push_back(-c / b);
+            }
+        } else {
+            double discriminant = b * b - 4.0 * a * c;
+            if (discriminant >= 0.0) {
+                roots.push_back((-b + std::sqrt(discriminant)) / (2.0 * a));
+                roots.push_back((-b - std::sqrt(discriminant)) / (2.0 * a));
+            }
+        }
+        for (double t : roots) {
+            if (t > 0.0 && t < 1.0) {
+                double value = evaluate(p0, p1, p2, p3, t);
+                minimum = std::min(minimum, static_cast<int64_t>(std::floor(value)));
+                maximum = std::max(maximum, static_cast<int64_t>(std::ceil(value)));
+            }
+        }
+    };
+    add_extremes(this->start.x, this->control_point1.x, this->control_point2.x, this->end.x, bounds.min_x, bounds.max_x);
+    add_extremes(this->start.y, this->control_point1.y, this->control_point2.y, this->end.y, bounds.min_y, bounds.max_y);
+    return bounds;
+}
+
+void open_json::types::shapes::bezier_curve::get_vertices(std::vector<point> &vertices) {
+    vertices.push_back(this->start);
+    vertices.push_back(this->control_point1);
+    vertices.push_back(this->control_point2);
+    vertices.push_back(this->end);
+}
+
 // OpenJSON
 void open_json::open_json_format::read(std::vector<std::string> files) {
     for (std::string file : files) {
-        std::cout<<"Parsing: "<<split(file, "/").back()<<std::endl;
-        std::ifstream file_stream(file);
-        json raw_json_data;
-        file_stream >> raw_json_data;
-        this->parsed_data.emplace_back(new data(split(split(file, "/").back(), "\\.").front(), raw_json_data));
+        std::ifstream file_stream(file, std::ios::binary);
+        compression::input_stream input(file_stream);
+        this->parsed_data.push_back(this->read_file(file, input));
         file_stream.close();
     }
 }
 
-void open_json::open_json_format::write(output_type type, std::string out_file) {
+std::function<bool(const std::string &)> open_json::open_json_format::get_section_filter(output_type type) const {
+    if (type == output_type::ALL && this->options.only_sections.empty()) {
+        return nullptr;
+    }
+    std::set<std::string> only_sections = this->options.only_sections;
+    return [type, only_sections](const std::string &key) { return is_section_needed(key, type, only_sections); };
+}
+
+// The parser of json.hpp 2.0 builds the value of a rejected key regardless and only decides at the end whether to store it,
+// refusing the start of that value is what makes it skip the contents. The depth it reports is off after such a value: it
+// stays incremented, and every empty array inside still decrements it. The first key after a dropped value is at the top
+// level again since nothing inside one reports keys, that key gives the top level depth back.
+json::parser_callback_t open_json::get_section_callback(std::function<bool(const std::string &)> keep_section) {
+    if (!keep_section) {
+        return nullptr;
+    }
+    typedef struct filter_state {
+        int top_level = 1;
+        bool rejected = false, dropping = false;
+    } filter_state;
+    std::shared_ptr<filter_state> state = std::make_shared<filter_state>();
+    return [keep_section, state](int depth, json::parse_event_t event, json &parsed) {
+        if (state->dropping) {
+            if (event != json::parse_event_t::key) {
+                return true;
+            }
+            state->dropping = false;
+            state->top_level = depth;
+        }
+        if (depth != state->top_level) {
+            return true;
+        }
+        switch (event) {
+            case json::parse_event_t::key:
+                state->rejected = !keep_section(parsed.get<std::string>());
+                return !state->rejected;
+            case json::parse_event_t::object_start:
+            case json::parse_event_t::array_start:
+                if (state->rejected) {
+                    state->rejected = false;
+                    state->dropping = true;
+                    return false;
+                }
+                return true;
+            case json::parse_event_t::value:
+                state->rejected = false;
+                return true;
+            default:
+                return true;
+        }
+    };
+}
+
+std::shared_ptr<open_json::data> open_json::open_json_format::read_file(const std::string &file, std::istream &input, output_type type) {
+    message_stream()<<"Parsing: "<<split(file, "/").back()<<std::endl;
+    json raw_json_data;
+    {
+        static instrument::metric &tokenize_timing = instrument::get_metric("tokenize");
+        instrument::scoped_timer timer(tokenize_timing, file);
+        try {
+            raw_json_data = json::parse(input, get_section_callback(this->get_section_filter(type)));
+        } catch (...) {
+            // A decompression failure shows up as a truncated document, report the cause instead
+            compression::input_stream *decompressed = dynamic_cast<compression::input_stream*>(&input);
+            if (decompressed != nullptr && !decompressed->get_error().empty()) {
+                throw parse_exception(decompressed->get_error());
+            }
+            throw;
+        }
+    }
+    static instrument::metric &decode_timing = instrument::get_metric("decode");
+    instrument::scoped_timer timer(decode_timing, file);
+    decode_timing.add(1);
+    return std::make_shared<data>(get_design_name(file), std::move(raw_json_data));
+}
+
+std::shared_ptr<open_json::data> open_json::open_json_format::read_buffer(const std::string &file, const std::string &document, output_type type) {
+    message_stream()<<"Parsing: "<<split(file, "/").back()<<std::endl;
+    json raw_json_data;
+    {
+        static instrument::metric &tokenize_timing = instrument::get_metric("tokenize");
+        instrument::scoped_timer timer(tokenize_timing, file);
+        std::function<bool(const std::string &)> keep_section = this->get_section_filter(type);
+        try {
+            // Sections and the chunks of large arrays are lexed concurrently, located through the structural index
+            raw_json_data = scan::parse_document(document, keep_section);
+        } catch (...) {
+            // Lexed again as a whole so the error names its position in the document, unwanted sections are still dropped
+            raw_json_data = json::parse(document, get_section_callback(keep_section));
+        }
+        tokenize_timing.add(document.size());
+    }
+    static instrument::metric &decode_timing = instrument::get_metric("decode");
+    instrument::scoped_timer timer(decode_timing, file);
+    decode_timing.add(1);
+    return std::make_shared<data>(get_design_name(file), std::move(raw_json_data));
+}
+
+std::shared_ptr<open_json::data> open_json::open_json_format::read_file_lazy(const std::string &file, std::istream &input) {
+    message_stream()<<"Parsing: "<<split(file, "/").back()<<std::endl;
+    std::shared_ptr<std::string> document = std::make_shared<std::string>();
+    {
+        static instrument::metric &read_timing = instrument::get_metric("io.read");
+        instrument::scoped_timer timer(read_timing, file);
+        document->assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        read_timing.add(document->size());
+    }
+    compression::input_stream *decompressed = dynamic_cast<compression::input_stream*>(&input);
+    if (decompressed != nullptr && !decompressed->get_error().empty()) {
+        throw parse_exception(decompressed->get_error());
+    }
+    return std::make_shared<data>(get_design_name(file), std::shared_ptr<const std::string>(document));
+}
+
+std::string open_json::open_json_format::get_design_name(const std::string &file) {
+    return split(split(file, "/").back(), "\\.").front();
+}
+
+std::string open_json::open_json_format::get_output_path(const std::string &design_name, const std::string &out_file) const {
     // XXX This really is only useful in testing, need to better specify output file names
+    return design_name + out_file + compression::get_extension(this->options.output_compression);
+}
+
+void open_json::open_json_format::print_stats(std::ostream &out) {
     for (auto data : this->parsed_data) {
-        std::ofstream file_stream(data->original_file_name + out_file);
-        json raw_json = data->get_json();
-        file_stream << std::setw(4) << raw_json << std::endl;
-        file_stream.close();
+        open_json::bounds::print_extents(out, data->original_file_name, *data->get_extents());
+    }
+}
+
+void open_json::open_json_format::write(output_type type, std::string out_file) {
+    for (auto data : this->parsed_data) {
+        this->write_file(*data, type, out_file);
     }
-}
\ No newline at end of file
+}
+
+void open_json::open_json_format::write_file(data &file_data, output_type type, const std::string &out_file) {
+    static instrument::metric &write_timing = instrument::get_metric("write");
+    instrument::scoped_timer timer(write_timing, file_data.original_file_name);
+    std::ofstream file_stream(this->get_output_path(file_data.original_file_name, out_file), std::ios::binary);
+    if (this->options.output_compression == compression_type::NONE) {
+        this->write_stream(file_data, type, file_stream);
+    } else {
+        compression::output_stream output(file_stream, this->options.output_compression);
+        this->write_stream(file_data, type, output);
+        output.close();
+    }
+    // Bytes on disk, after compression
+    std::streamoff written = file_stream.tellp();
+    if (written > 0) {
+        write_timing.add(static_cast<uint64_t>(written));
+    }
+    file_stream.close();
+}
+
+void open_json::open_json_format::write_stream(data &file_data, output_type type, std::ostream &output) {
+    static instrument::metric &serialize_timing = instrument::get_metric("serialize");
+    instrument::scoped_timer timer(serialize_timing, file_data.original_file_name);
+    open_json::serialize::write(output, file_data, this->options.curve_tolerance, type, this->options.only_sections);
+    output << std::endl;
+}
@@ -0,0 +1,205 @@
+#include "parallel.hpp"
+#include "instrument.hpp"
+
+namespace {
+    // Index of the pool queue owned by the current thread, external threads don't own one
+    thread_local size_t current_queue = static_cast<size_t>(-1);
+};
+
+// Task Group
+void open_json::parallel::task_group::rethrow_if_failed() {
+    std::lock_guard<std::mutex> lock(this->error_lock);
+    if (this->error) {
+        std::exception_ptr error = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+// Work Stealing Pool
+open_json::parallel::work_stealing_pool::work_stealing_pool(unsigned int thread_count) : queued(0), next_queue(0), stopping(false) {
+    for (unsigned int i = 0; i < thread_count; i++) {
+        this->queues.emplace_back(new worker_queue());
+    }
+    for (unsigned int i = 0; i < thread_count; i++) {
+        this->threads.emplace_back(&work_stealing_pool::worker_loop, this, i);
+    }
+}
+
+open_json::parallel::work_stealing_pool::~work_stealing_pool() {
+    {
+        std::lock_guard<std::mutex> lock(this->sleep_lock);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (std::thread &thread : this->threads) {
+        thread.join();
+    }
+}
+
+bool open_json::parallel::work_stealing_pool::try_pop(size_t queue_index, task &next) {
+    worker_queue &queue = *this->queues[queue_index];
+    std::lock_guard<std::mutex> lock(queue.lock);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    next = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool open_json::parallel::work_stealing_pool::try_steal(size_t thief_index, task &next) {
+    for (size_t offset = 1; offset <= this->queues.size(); offset++) {
+        worker_queue &queue = *this->queues[(thief_index + offset) % this->queues.size()];
+        std::lock_guard<std::mutex> lock(queue.lock);
+        if (!queue.tasks.empty()) {
+            next = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool open_json::parallel::work_stealing_pool::try_run_one() {
+    if (this->queues.empty()) {
+        return false;
+    }
+    task next;
+    bool found = current_queue < this->queues.size() ? this->try_pop(current_queue, next) || this->try_steal(current_queue, next) : this->try_steal(0, next);
+    if (found) {
+        this->run(next);
+    }
+    return found;
+}
+
+void open_json::parallel::work_stealing_pool::run(task &next) {
+    this->queued--;
+    try {
+        next.function();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(next.group->error_lock);
+        if (!next.group->error) {
+            next.group->error = std::current_exception();
+        }
+    }
+    next.group->outstanding--;
+}
+
+void open_json::parallel::work_stealing_pool::worker_loop(size_t queue_index) {
+    current_queue = queue_index;
+    instrument::set_thread_name("worker " + std::to_string(queue_index));
+    while (true) {
+        if (this->try_run_one()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(this->sleep_lock);
+        this->wake.wait(lock, [this]() { return this->stopping || this->queued > 0; });
+        if (this->stopping) {
+            return;
+        }
+    }
+}
+
+void open_json::parallel::work_stealing_pool::submit(task_group &group, std::function<void()> function) {
+    group.outstanding++;
+    if (this->queues.empty()) {
+        task next = {function, &group};
+        this->queued++;
+        this->run(next);
+        return;
+    }
+    // Workers push onto their own queue, everyone else spreads the work around
+    size_t queue_index = current_queue < this->queues.size() ? current_queue : this->next_queue++ % this->queues.size();
+    {
+        std::lock_guard<std::mutex> lock(this->queues[queue_index]->lock);
+        this->queues[queue_index]->tasks.push_back({function, &group});
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->sleep_lock);
+        this->queued++;
+    }
+    this->wake.notify_one();
+}
+
+void open_json::parallel::work_stealing_pool::wait(task_group &group) {
+    while (!group.is_done()) {
+        if (!this->try_run_one()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+open_json::parallel::work_stealing_pool &open_json::parallel::work_stealing_pool::shared() {
+    static work_stealing_pool pool(std::max(1u, get_concurrency() - 1));
+    return pool;
+}
+
+// Task Graph
+size_t open_json::parallel::task_graph::add(std::function<void()> function, const std::vector<size_t> &dependencies) {
+    size_t index = this->nodes.size();
+    this->nodes.emplace_back(new node());
+    this->nodes.back()->function = function;
+    this->nodes.back()->dependency_count = dependencies.size();
+    for (size_t dependency : dependencies) {
+        this->nodes.at(dependency)->successors.push_back(index);
+    }
+    return index;
+}
+
+void open_json::parallel::task_graph::schedule(work_stealing_pool &pool, task_group &group, size_t index) {
+    pool.submit(group, [this, &pool, &group, index]() {
+        node &current = *this->nodes[index];
+        try {
+            current.function();
+        } catch (...) {
+            current.error = std::current_exception();
+            return;
+        }
+        for (size_t successor : current.successors) {
+            if (--this->nodes[successor]->remaining == 0) {
+                this->schedule(pool, group, successor);
+            }
+        }
+    });
+}
+
+void open_json::parallel::task_graph::run() {
+    if (get_concurrency() <= 1) {
+        // Insertion order is already a valid order
+        std::vector<bool> failed(this->nodes.size(), false);
+        for (size_t index = 0; index < this->nodes.size(); index++) {
+            node &current = *this->nodes[index];
+            if (!failed[index]) {
+                try {
+                    current.function();
+                } catch (...) {
+                    current.error = std::current_exception();
+                    failed[index] = true;
+                }
+            }
+            if (failed[index]) {
+                for (size_t successor : current.successors) {
+                    failed[successor] = true;
+                }
+            }
+        }
+    } else {
+        work_stealing_pool &pool = work_stealing_pool::shared();
+        task_group group;
+        for (auto &current : this->nodes) {
+            current->remaining = current->dependency_count;
+        }
+        for (size_t index = 0; index < this->nodes.size(); index++) {
+            if (this->nodes[index]->dependency_count == 0) {
+                this->schedule(pool, group, index);
+            }
+        }
+        pool.wait(group);
+    }
+    for (auto &current : this->nodes) {
+        if (current->error) {
+            std::rethrow_exception(current->error);
+        }
+    }
+}
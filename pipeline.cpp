@@ -0,0 +1,306 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <thread>
+
+#include "pipeline.hpp"
+#include "bounds.hpp"
+#include "compression.hpp"
+#include "instrument.hpp"
+#include "library.hpp"
+#include "openjson.hpp"
+#include "parallel.hpp"
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+    
+    double seconds_since(clock_type::time_point start) {
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+    
+    // Reads a string in place, the raw file stays in memory once while its design moves through the stages
+    class memory_buffer : public std::streambuf {
+    public:
+        explicit memory_buffer(const std::string &contents) {
+            char *begin = const_cast<char*>(contents.data());
+            this->setg(begin, begin, begin + contents.size());
+        }
+    };
+    
+    // Plain documents are already in memory and are lexed through the structural index, compressed ones are streamed
+    std::shared_ptr<open_json::data> read_contents(open_json::open_json_format &format, const std::string &file, const std::string &contents, output_type type) {
+        if (open_json::compression::detect(contents.data(), contents.size()) == compression_type::NONE) {
+            return format.read_buffer(file, contents, type);
+        }
+        memory_buffer buffer(contents);
+        std::istream compressed(&buffer);
+        open_json::compression::input_stream input(compressed);
+        return format.read_file(file, input, type);
+    }
+    
+    typedef struct file_job {
+        std::string file;
+        std::shared_ptr<std::string> contents;
+        std::string cache_key; // Empty without a conversion cache
+    } file_job;
+    
+    typedef struct design_job {
+        std::shared_ptr<open_json::data> design;
+        std::shared_ptr<open_json::diagnostic_capture> diagnostics;
+        std::string cache_key;
+        std::shared_ptr<file_job> cached; // Set instead of the design on a cache hit
+    } design_job;
+    
+    // Bounded queue plus end of stream, producers wait while it is full which holds back the stages before it
+    template<typename value_type>
+    class channel {
+    private:
+        open_json::parallel::bounded_queue<value_type> queue;
+        std::atomic<bool> closed;
+        std::atomic<bool> &cancelled; // Set when the consumer or producer has stopped early
+        open_json::pipeline::queue_stats &stats;
+        
+        static void back_off(size_t attempt) {
+            if (attempt < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    public:
+        channel(size_t capacity, std::atomic<bool> &cancel_flag, open_json::pipeline::queue_stats &queue_stats) : queue(capacity), closed(false), cancelled(cancel_flag), stats(queue_stats) {
+            this->stats.capacity = this->queue.get_capacity();
+        }
+        
+        // Returns false if the run was cancelled while waiting for room
+        bool push(value_type value) {
+            static open_json::instrument::metric &full_timing = open_json::instrument::get_metric("pipeline.wait_full");
+            std::unique_ptr<open_json::instrument::scoped_timer> wait;
+            for (size_t attempt = 0; !this->queue.try_push(value); attempt++) {
+                if (this->cancelled) {
+                    return false;
+                }
+                if (attempt == 0) {
+                    this->stats.full_waits++;
+                    wait.reset(new open_json::instrument::scoped_timer(full_timing, this->stats.name));
+                }
+                back_off(attempt);
+            }
+            wait.reset();
+            size_t occupancy = this->queue.get_size();
+            this->stats.max_occupancy = std::max(this->stats.max_occupancy, occupancy);
+            this->stats.occupancy_sum += occupancy;
+            this->stats.samples++;
+            return true;
+        }
+        
+        // Returns false once the channel is closed and drained, or the run was cancelled
+        bool pop(value_type &value) {
+            static open_json::instrument::metric &empty_timing = open_json::instrument::get_metric("pipeline.wait_empty");
+            std::unique_ptr<open_json::instrument::scoped_timer> wait;
+            for (size_t attempt = 0; !this->queue.try_pop(value); attempt++) {
+                if (this->cancelled) {
+                    return false;
+                }
+                if (attempt == 0) {
+                    wait.reset(new open_json::instrument::scoped_timer(empty_timing, this->stats.name));
+                }
+                if (this->closed) {
+                    // Pushes may have landed between the failed pop and the close
+                    return this->queue.try_pop(value);
+                }
+                back_off(attempt);
+            }
+            return true;
+        }
+        
+        void close() { this->closed = true; }
+    };
+};
+
+bool open_json::pipeline::conversion_pipeline::run(const std::vector<std::string> &files, output_type type, const std::string &out_file) {
+    clock_type::time_point run_start = clock_type::now();
+    this->stages.assign(3, stage_stats());
+    this->stages[0].name = "read";
+    this->stages[1].name = "parse";
+    this->stages[2].name = "write";
+    this->queues.assign(2, queue_stats());
+    this->queues[0].name = "read -> parse";
+    this->queues[1].name = "parse -> write";
+    
+    // A parse error stops the reader but still writes every design parsed before it, a write error stops everything
+    std::atomic<bool> stop_reading(false), stop_parsing(false);
+    channel<file_job> read_queue(this->queue_capacity, stop_reading, this->queues[0]);
+    channel<design_job> parse_queue(this->queue_capacity, stop_parsing, this->queues[1]);
+    open_json::open_json_format format(this->options);
+    std::mutex error_lock;
+    std::string error;
+    auto fail = [&](const std::string &message, bool stop_parser) {
+        std::lock_guard<std::mutex> lock(error_lock);
+        if (error.empty()) {
+            error = message;
+        }
+        stop_reading = true;
+        if (stop_parser) {
+            stop_parsing = true;
+        }
+    };
+    
+    std::thread reader([&]() {
+        instrument::set_thread_name("pipeline read");
+        stage_stats &stats = this->stages[0];
+        for (const std::string &file : files) {
+            clock_type::time_point start = clock_type::now();
+            std::shared_ptr<std::string> contents;
+            {
+                static instrument::metric &read_timing = instrument::get_metric("io.read");
+                instrument::scoped_timer timer(read_timing, file);
+                std::ifstream file_stream(file, std::ios::binary);
+                contents = std::make_shared<std::string>((std::istreambuf_iterator<char>(file_stream)), std::istreambuf_iterator<char>());
+                read_timing.add(contents->size());
+            }
+            std::string cache_key;
+            if (this->output_cache.is_usable()) {
+                static instrument::metric &key_timing = instrument::get_metric("cache.key");
+                instrument::scoped_timer timer(key_timing, file);
+                cache_key = cache::conversion_cache::make_key(*contents, this->options, type);
+            }
+            stats.busy_seconds += seconds_since(start);
+            stats.items++;
+            stats.bytes += contents->size();
+            if (!read_queue.push({file, contents, cache_key})) {
+                break;
+            }
+        }
+        read_queue.close();
+    });
+    
+    std::thread parser([&]() {
+        instrument::set_thread_name("pipeline parse");
+        stage_stats &stats = this->stages[1];
+        file_job job;
+        while (read_queue.pop(job)) {
+            clock_type::time_point start = clock_type::now();
+            design_job design;
+            design.diagnostics = std::make_shared<open_json::diagnostic_capture>();
+            design.cache_key = job.cache_key;
+            if (!job.cache_key.empty() && this->output_cache.lookup(job.cache_key)) {
+                design.cached = std::make_shared<file_job>(job);
+                job = file_job();
+                if (!parse_queue.push(design)) {
+                    break;
+                }
+                continue;
+            }
+            try {
+                open_json::diagnostic_capture::scope capture(*design.diagnostics);
+                design.design = read_contents(format, job.file, *job.contents, type);
+            } catch (const parse_exception &e) {
+                fail(std::string("Parse Error: ") + e.what(), false);
+            } catch (std::exception &e) {
+                fail(std::string("Parse Error: ") + job.file + ": " + e.what(), false);
+            }
+            if (!design.design) {
+                // Still handed to the writer so the diagnostics come out after those of the designs before it
+                parse_queue.push(design);
+                break;
+            }
+            stats.busy_seconds += seconds_since(start);
+            stats.items++;
+            stats.bytes += job.contents->size();
+            job = file_job();
+            if (!parse_queue.push(design)) {
+                break;
+            }
+        }
+        parse_queue.close();
+    });
+    
+    stage_stats &stats = this->stages[2];
+    design_job design;
+    while (parse_queue.pop(design)) {
+        design.diagnostics->replay();
+        if (design.cached) {
+            clock_type::time_point start = clock_type::now();
+            std::string name = open_json::open_json_format::get_design_name(design.cached->file);
+            std::string output_file = format.get_output_path(name, out_file);
+            if (this->output_cache.fetch(design.cache_key, output_file)) {
+                std::cout<<"Cached: "<<name<<" -> "<<output_file<<std::endl;
+                stats.busy_seconds += seconds_since(start);
+                stats.items++;
+                design = design_job();
+                continue;
+            }
+            // Evicted since the lookup, converted here instead
+            try {
+                design.design = read_contents(format, design.cached->file, *design.cached->contents, type);
+            } catch (const parse_exception &e) {
+                fail(std::string("Parse Error: ") + e.what(), true);
+                break;
+            } catch (std::exception &e) {
+                fail(std::string("Parse Error: ") + design.cached->file + ": " + e.what(), true);
+                break;
+            }
+        }
+        if (!design.design) {
+            break;
+        }
+        if (this->options.print_stats) {
+            open_json::bounds::print_extents(std::cout, design.design->original_file_name, *design.design->get_extents());
+        }
+        if (this->options.memory_report && design.design->memory_usage) {
+            design.design->memory_usage->print_report(std::cout);
+        }
+        clock_type::time_point start = clock_type::now();
+        try {
+            std::string output_file = format.get_output_path(design.design->original_file_name, out_file);
+            format.write_file(*design.design, type, out_file);
+            if (!design.cache_key.empty()) {
+                this->output_cache.store(design.cache_key, output_file);
+            }
+        } catch (std::exception &e) {
+            fail(std::string("Write Error: ") + e.what(), true);
+            break;
+        }
+        stats.busy_seconds += seconds_since(start);
+        stats.items++;
+        design = design_job();
+    }
+    reader.join();
+    parser.join();
+    this->wall_seconds = seconds_since(run_start);
+    
+    if (!error.empty()) {
+        std::cerr<<error<<std::endl;
+        return false;
+    }
+    return true;
+}
+
+void open_json::pipeline::conversion_pipeline::print_report(std::ostream &out) const {
+    out<<"Pipeline ("<<std::fixed<<std::setprecision(3)<<this->wall_seconds<<" s):"<<std::endl;
+    for (const stage_stats &stage : this->stages) {
+        out<<"  Stage "<<stage.name<<": "<<stage.items<<" designs, "<<stage.busy_seconds<<" s busy";
+        if (stage.busy_seconds > 0.0) {
+            out<<", "<<stage.items / stage.busy_seconds<<" designs/s";
+            if (stage.bytes > 0) {
+                out<<", "<<stage.bytes / stage.busy_seconds / 1e6<<" MB/s";
+            }
+        }
+        out<<std::endl;
+    }
+    for (const queue_stats &queue : this->queues) {
+        out<<"  Queue "<<queue.name<<": capacity "<<queue.capacity<<", max "<<queue.max_occupancy
+           <<", mean "<<(queue.samples > 0 ? static_cast<double>(queue.occupancy_sum) / queue.samples : 0.0)<<", "<<queue.full_waits<<" waits when full"<<std::endl;
+    }
+    out.unsetf(std::ios_base::floatfield);
+    if (this->output_cache.is_usable()) {
+        out<<"  ";
+        this->output_cache.print_stats(out);
+    }
+    out<<"  ";
+    open_json::library::component_cache::shared().print_stats(out);
+}
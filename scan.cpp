@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <streambuf>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCAN_HAVE_SIMD_KERNELS
+#endif
+
+#include "scan.hpp"
+#include "converter.hpp"
+#include "parallel.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+    const size_t block_size = 64;
+    const size_t array_chunk_elements = 1024;
+
+    // One bit per byte of a 64 byte block
+    typedef struct block_masks {
+        uint64_t quotes, backslashes, structurals;
+    } block_masks;
+
+    // Carried from one block to the next
+    typedef struct index_state {
+        uint64_t ends_odd_backslash = 0; // 1 when the previous block ended in an odd run of backslashes
+        uint64_t in_string = 0; // All ones when the previous block ended inside a string
+    } index_state;
+
+#ifdef SCAN_HAVE_SIMD_KERNELS
+    // Setting bit 5 folds the brackets onto the braces, '[' | 0x20 is '{' and ']' | 0x20 is '}'
+    block_masks classify_sse2(const char *block) {
+        block_masks masks = {0, 0, 0};
+        for (size_t i = 0; i < 4; i++) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16));
+            __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+            __m128i structurals = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+                                               _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8(','))));
+            masks.quotes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"'))))) << (i * 16);
+            masks.backslashes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))))) << (i * 16);
+            masks.structurals |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(structurals))) << (i * 16);
+        }
+        return masks;
+    }
+
+    __attribute__((target("avx2")))
+    block_masks classify_avx2(const char *block) {
+        block_masks masks = {0, 0, 0};
+        for (size_t i = 0; i < 2; i++) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i * 32));
+            __m256i folded = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+            __m256i structurals = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+                                                  _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(','))));
+            masks.quotes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"'))))) << (i * 32);
+            masks.backslashes |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))))) << (i * 32);
+            masks.structurals |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(structurals))) << (i * 32);
+        }
+        return masks;
+    }
+#else
+    block_masks classify_scalar(const char *block) {
+        block_masks masks = {0, 0, 0};
+        for (size_t i = 0; i < block_size; i++) {
+            uint64_t bit = uint64_t(1) << i;
+            switch (block[i]) {
+                case '"': masks.quotes |= bit; break;
+                case '\\': masks.backslashes |= bit; break;
+                case '{': case '}': case '[': case ']': case ':': case ',': masks.structurals |= bit; break;
+                default: break;
+            }
+        }
+        return masks;
+    }
+#endif
+
+    typedef block_masks (*classify_function)(const char *block);
+
+    classify_function select_kernel() {
+#ifdef SCAN_HAVE_SIMD_KERNELS
+        if (__builtin_cpu_supports("avx2")) {
+            return &classify_avx2;
+        }
+        return &classify_sse2;
+#else
+        return &classify_scalar;
+#endif
+    }
+
+    // Characters escaped by an odd run of backslashes, runs may carry over from the previous block
+    uint64_t find_escaped(uint64_t backslashes, index_state &state) {
+        const uint64_t even_bits = 0x5555555555555555ULL, odd_bits = ~even_bits;
+        uint64_t starts = backslashes & ~(backslashes << 1);
+        uint64_t even_start_mask = even_bits ^ state.ends_odd_backslash;
+        uint64_t even_starts = starts & even_start_mask, odd_starts = starts & ~even_start_mask;
+        uint64_t even_carries = backslashes + even_starts;
+        uint64_t odd_carries;
+        bool ends_odd_backslash = __builtin_add_overflow(backslashes, odd_starts, &odd_carries);
+        odd_carries |= state.ends_odd_backslash;
+        state.ends_odd_backslash = ends_odd_backslash ? 1 : 0;
+        uint64_t even_carry_ends = even_carries & ~backslashes, odd_carry_ends = odd_carries & ~backslashes;
+        return (even_carry_ends & odd_bits) | (odd_carry_ends & even_bits);
+    }
+
+    // Every bit becomes the xor of itself and all lower bits, so bits between an opening and a closing quote are set
+    uint64_t prefix_xor(uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    void index_block(const block_masks &masks, size_t offset, index_state &state, std::vector<uint32_t> &positions) {
+        uint64_t quotes = masks.quotes & ~find_escaped(masks.backslashes, state);
+        uint64_t in_string = prefix_xor(quotes) ^ state.in_string;
+        state.in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+        uint64_t structurals = masks.structurals & ~in_string;
+        while (structurals != 0) {
+            positions.push_back(static_cast<uint32_t>(offset + __builtin_ctzll(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+
+    // Hands a byte range of the document to the lexer in place, optionally between brackets so runs of array elements
+    // lex as an array of their own
+    class range_buffer : public std::streambuf {
+    private:
+        const char *pieces[3][2];
+        size_t next_piece;
+    protected:
+        int_type underflow() override {
+            while (this->next_piece < 3) {
+                const char *begin = this->pieces[this->next_piece][0], *end = this->pieces[this->next_piece][1];
+                this->next_piece++;
+                if (begin != end) {
+                    this->setg(const_cast<char*>(begin), const_cast<char*>(begin), const_cast<char*>(end));
+                    return traits_type::to_int_type(*begin);
+                }
+            }
+            return traits_type::eof();
+        }
+    public:
+        range_buffer(const std::string &document, size_t begin, size_t end, bool bracketed) : next_piece(0) {
+            static const char open = '[', close = ']';
+            this->pieces[0][0] = &open;
+            this->pieces[0][1] = bracketed ? &open + 1 : &open;
+            this->pieces[1][0] = document.data() + begin;
+            this->pieces[1][1] = document.data() + end;
+            this->pieces[2][0] = &close;
+            this->pieces[2][1] = bracketed ? &close + 1 : &close;
+        }
+    };
+
+    json parse_range(const std::string &document, size_t begin, size_t end, bool bracketed = false) {
+        range_buffer buffer(document, begin, end, bracketed);
+        std::istream input(&buffer);
+        return json::parse(input);
+    }
+
+    bool is_whitespace(char character) {
+        return character == ' ' || character == '\n' || character == '\r' || character == '\t';
+    }
+
+    size_t skip_whitespace(const std::string &document, size_t position) {
+        while (position < document.size() && is_whitespace(document[position])) {
+            position++;
+        }
+        return position;
+    }
+
+    size_t trim_whitespace(const std::string &document, size_t begin, size_t end) {
+        while (end > begin && is_whitespace(document[end - 1])) {
+            end--;
+        }
+        return end;
+    }
+
+    // From the opening quote, returns the position after the closing quote
+    size_t skip_string(const std::string &document, size_t position) {
+        for (position++; position < document.size(); position++) {
+            if (document[position] == '\\') {
+                position++;
+            } else if (document[position] == '"') {
+                return position + 1;
+            }
+        }
+        throw parse_exception("Unterminated string in the design");
+    }
+
+    // Returns the position after the value starting at position, for documents without an index
+    size_t skip_value(const std::string &document, size_t position) {
+        if (position >= document.size()) {
+            throw parse_exception("Missing value in the design");
+        }
+        char first = document[position];
+        if (first == '"') {
+            return skip_string(document, position);
+        }
+        if (first != '{' && first != '[') {
+            while (position < document.size() && !is_whitespace(document[position]) && document[position] != ',' && document[position] != '}' && document[position] != ']') {
+                position++;
+            }
+            return position;
+        }
+        size_t depth = 0;
+        while (position < document.size()) {
+            char character = document[position];
+            if (character == '"') {
+                position = skip_string(document, position);
+                continue;
+            }
+            if (character == '{' || character == '[') {
+                depth++;
+            } else if (character == '}' || character == ']') {
+                if (--depth == 0) {
+                    return position + 1;
+                }
+            }
+            position++;
+        }
+        throw parse_exception("Unterminated object or array in the design");
+    }
+
+    // Reads the key starting at position, returns the position after its closing quote
+    size_t read_key(const std::string &document, size_t position, std::string &key) {
+        if (position >= document.size() || document[position] != '"') {
+            throw parse_exception("Expected a key in the design");
+        }
+        size_t key_end = skip_string(document, position);
+        key = document.substr(position + 1, key_end - position - 2);
+        if (key.find('\\') != std::string::npos) {
+            key = json::parse(document.substr(position, key_end - position)).get<std::string>();
+        }
+        return key_end;
+    }
+
+    void check_end_of_document(const std::string &document, size_t position) {
+        if (skip_whitespace(document, position) != document.size()) {
+            throw parse_exception("Unexpected content after the end of the design");
+        }
+    }
+
+    std::vector<open_json::scan::section_range> find_sections_scalar(const std::string &document) {
+        std::vector<open_json::scan::section_range> sections;
+        size_t position = skip_whitespace(document, 0);
+        if (position >= document.size() || document[position] != '{') {
+            throw parse_exception("The design is not a JSON object");
+        }
+        position = skip_whitespace(document, position + 1);
+        if (position < document.size() && document[position] == '}') {
+            check_end_of_document(document, position + 1);
+            return sections;
+        }
+        while (true) {
+            open_json::scan::section_range section;
+            position = skip_whitespace(document, read_key(document, position, section.key));
+            if (position >= document.size() || document[position] != ':') {
+                throw parse_exception("Expected a colon after the key: " + section.key);
+            }
+            section.begin = skip_whitespace(document, position + 1);
+            section.end = skip_value(document, section.begin);
+            sections.push_back(section);
+            position = skip_whitespace(document, section.end);
+            if (position < document.size() && document[position] == ',') {
+                position = skip_whitespace(document, position + 1);
+            } else if (position < document.size() && document[position] == '}') {
+                check_end_of_document(document, position + 1);
+                return sections;
+            } else {
+                throw parse_exception("Expected a comma or the end of the design after: " + section.key);
+            }
+        }
+    }
+};
+
+open_json::scan::structural_index::structural_index(const std::string &document) : usable(document.size() < std::numeric_limits<uint32_t>::max()) {
+    if (!this->usable) {
+        return;
+    }
+    static const classify_function classify = select_kernel();
+    // Roughly one structural character per 8 bytes in OpenJSON
+    this->positions.reserve(document.size() / 8);
+    index_state state;
+    size_t full_blocks = document.size() / block_size * block_size;
+    for (size_t offset = 0; offset < full_blocks; offset += block_size) {
+        index_block(classify(document.data() + offset), offset, state, this->positions);
+    }
+    if (full_blocks < document.size()) {
+        char tail[block_size];
+        std::memset(tail, ' ', block_size);
+        std::memcpy(tail, document.data() + full_blocks, document.size() - full_blocks);
+        index_block(classify(tail), full_blocks, state, this->positions);
+    }
+}
+
+size_t open_json::scan::structural_index::lower_bound(size_t offset) const {
+    return std::lower_bound(this->positions.begin(), this->positions.end(), offset) - this->positions.begin();
+}
+
+std::vector<open_json::scan::section_range> open_json::scan::find_sections(const std::string &document, const structural_index &index) {
+    if (!index.is_usable()) {
+        return find_sections_scalar(document);
+    }
+    const std::vector<uint32_t> &positions = index.get_positions();
+    size_t start = skip_whitespace(document, 0);
+    if (start >= document.size() || document[start] != '{' || positions.empty() || positions.front() != start) {
+        throw parse_exception("The design is not a JSON object");
+    }
+
+    std::vector<section_range> sections;
+    section_range current;
+    size_t key_end = 0, depth = 0;
+    bool has_key = false, has_value = false;
+    // Values only end at a comma or the closing brace of the design, anything nested in between is skipped
+    auto finish_value = [&](size_t position) {
+        if (has_key && !has_value) {
+            throw parse_exception("Expected a colon after the key: " + current.key);
+        }
+        if (has_value) {
+            current.end = trim_whitespace(document, current.begin, position);
+            if (current.end == current.begin) {
+                throw parse_exception("Missing value for the key: " + current.key);
+            }
+            sections.push_back(current);
+        }
+        has_key = has_value = false;
+    };
+    for (uint32_t position : positions) {
+        char character = document[position];
+        if (character == '{' || character == '[') {
+            if (depth++ == 0) {
+                size_t key_start = skip_whitespace(document, position + 1);
+                if (key_start < document.size() && document[key_start] != '}') {
+                    key_end = read_key(document, key_start, current.key);
+                    has_key = true;
+                }
+            }
+        } else if (character == '}' || character == ']') {
+            if (--depth == 0) {
+                if (character != '}') {
+                    throw parse_exception("The design is not a JSON object");
+                }
+                finish_value(position);
+                check_end_of_document(document, position + 1);
+                return sections;
+            }
+        } else if (depth != 1) {
+            continue;
+        } else if (character == ':') {
+            if (!has_key || has_value || skip_whitespace(document, key_end) != position) {
+                throw parse_exception("Expected a key before the colon in the design");
+            }
+            current.begin = skip_whitespace(document, position + 1);
+            has_value = true;
+        } else {
+            if (!has_value) {
+                throw parse_exception("Expected a value before the comma in the design");
+            }
+            finish_value(position);
+            key_end = read_key(document, skip_whitespace(document, position + 1), current.key);
+            has_key = true;
+        }
+    }
+    throw parse_exception("Unterminated object or array in the design");
+}
+
+std::vector<open_json::scan::section_range> open_json::scan::find_sections(const std::string &document) {
+    structural_index index(document);
+    return find_sections(document, index);
+}
+
+std::vector<std::pair<size_t, size_t>> open_json::scan::split_array(const std::string &document, const structural_index &index, size_t begin, size_t end, size_t elements_per_chunk) {
+    std::vector<std::pair<size_t, size_t>> chunks;
+    if (end - begin < 2 || document[begin] != '[' || document[end - 1] != ']') {
+        throw parse_exception("Expected an array in the design");
+    }
+    size_t chunk_begin = skip_whitespace(document, begin + 1);
+    if (chunk_begin >= end - 1) {
+        return chunks;
+    }
+    const std::vector<uint32_t> &positions = index.get_positions();
+    size_t depth = 0, elements = 1;
+    for (size_t i = index.lower_bound(begin + 1); i < positions.size() && positions[i] < end - 1; i++) {
+        char character = document[positions[i]];
+        if (character == '{' || character == '[') {
+            depth++;
+        } else if (character == '}' || character == ']') {
+            if (depth-- == 0) {
+                throw parse_exception("Unbalanced array in the design");
+            }
+        } else if (character == ',' && depth == 0 && elements++ % elements_per_chunk == 0) {
+            chunks.push_back(std::make_pair(chunk_begin, trim_whitespace(document, chunk_begin, positions[i])));
+            chunk_begin = skip_whitespace(document, positions[i] + 1);
+        }
+    }
+    chunks.push_back(std::make_pair(chunk_begin, trim_whitespace(document, chunk_begin, end - 1)));
+    return chunks;
+}
+
+json open_json::scan::parse_value(const std::string &document, const structural_index &index, size_t begin, size_t end) {
+    if (!index.is_usable() || document[begin] != '[') {
+        return parse_range(document, begin, end);
+    }
+    std::vector<std::pair<size_t, size_t>> chunks = split_array(document, index, begin, end, array_chunk_elements);
+    if (chunks.size() <= 1) {
+        return parse_range(document, begin, end);
+    }
+    std::vector<json> parsed(chunks.size());
+    parallel::for_each_index(chunks.size(), [&](size_t chunk) {
+        parsed[chunk] = parse_range(document, chunks[chunk].first, chunks[chunk].second, true);
+    });
+    json elements(json::value_t::array);
+    elements.get_ptr<json::array_t*>()->reserve(chunks.size() * array_chunk_elements);
+    for (json &chunk : parsed) {
+        for (json &element : chunk) {
+            elements.push_back(std::move(element));
+        }
+    }
+    return elements;
+}
+
+json open_json::scan::parse_document(const std::string &document, std::function<bool(const std::string &)> keep_section) {
+    structural_index index(document);
+    std::vector<section_range> sections = find_sections(document, index);
+    if (keep_section) {
+        sections.erase(std::remove_if(sections.begin(), sections.end(), [&](const section_range &section) { return !keep_section(section.key); }), sections.end());
+    }
+    std::vector<json> values(sections.size());
+    parallel::for_each_index(sections.size(), [&](size_t section) {
+        values[section] = parse_value(document, index, sections[section].begin, sections[section].end);
+    });
+    json design(json::value_t::object);
+    for (size_t section = 0; section < sections.size(); section++) {
+        design[sections[section].key] = std::move(values[section]);
+    }
+    return design;
+}
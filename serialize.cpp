@@ -0,0 +1,107 @@
+#include <algorithm>
+
+#include "serialize.hpp"
+#include "flatten.hpp"
+#include "instrument.hpp"
+#include "parallel.hpp"
+
+namespace {
+    typedef struct work_item {
+        size_t section, chunk;
+    } work_item;
+    
+    std::string indentation(size_t depth) {
+        return std::string(depth * open_json::serialize::indent_width, ' ');
+    }
+};
+
+std::string open_json::serialize::render(const json &value, size_t depth) {
+    std::string text = value.dump(indent_width);
+    if (depth == 0) {
+        return text;
+    }
+    // Strings are escaped by dump, every raw new line is part of the layout
+    std::string indented, prefix = "\n" + indentation(depth);
+    indented.reserve(text.size() + text.size() / 8);
+    size_t start = 0;
+    for (size_t line_end = text.find('\n'); line_end != std::string::npos; line_end = text.find('\n', start)) {
+        indented.append(text, start, line_end - start).append(prefix);
+        start = line_end + 1;
+    }
+    indented.append(text, start, std::string::npos);
+    return indented;
+}
+
+void open_json::serialize::write(std::ostream &out, data &file, double curve_tolerance, output_type type, const std::set<std::string> &only_sections) {
+    std::vector<data::json_section> sections = file.get_json_sections(type, only_sections);
+    std::stable_sort(sections.begin(), sections.end(), [](const data::json_section &a, const data::json_section &b) { return a.key < b.key; });
+    
+    std::vector<std::vector<std::string>> rendered(sections.size());
+    std::vector<work_item> items;
+    for (size_t section = 0; section < sections.size(); section++) {
+        size_t chunk_count = sections[section].is_array ? (sections[section].count + chunk_size - 1) / chunk_size : 1;
+        rendered[section].resize(chunk_count);
+        for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+            items.push_back({section, chunk});
+        }
+    }
+    
+    // Timings are added once per chunk, building the JSON of an element and rendering it are counted apart
+    std::vector<instrument::metric*> section_timings;
+    for (const data::json_section &section : sections) {
+        section_timings.push_back(&instrument::get_metric("get_json." + section.key));
+    }
+    static instrument::metric &flatten_timing = instrument::get_metric("flatten");
+    static instrument::metric &render_timing = instrument::get_metric("render");
+    static instrument::metric &chunk_timing = instrument::get_metric("serialize.chunk");
+    
+    const std::string element_separator = ",\n" + indentation(2);
+    open_json::parallel::for_each_index(items.size(), [&](size_t item_index) {
+        const work_item &item = items[item_index];
+        const data::json_section &section = sections[item.section];
+        std::string &text = rendered[item.section][item.chunk];
+        size_t first = item.chunk * chunk_size, last = section.is_array ? std::min(section.count, first + chunk_size) : 1;
+        uint64_t build_time = 0, flatten_time = 0, render_time = 0;
+        instrument::scoped_timer chunk_timer(chunk_timing, section.key);
+        for (size_t index = first; index < last; index++) {
+            instrument::clock_type::time_point start = instrument::clock_type::now();
+            json value = section.get_value(index);
+            build_time += instrument::nanoseconds_since(start);
+            if (curve_tolerance > 0.0) {
+                start = instrument::clock_type::now();
+                open_json::flatten::normalize(value, curve_tolerance);
+                flatten_time += instrument::nanoseconds_since(start);
+            }
+            if (index != first) {
+                text += element_separator;
+            }
+            start = instrument::clock_type::now();
+            text += render(value, section.is_array ? 2 : 1);
+            render_time += instrument::nanoseconds_since(start);
+        }
+        section_timings[item.section]->add_time(build_time, last - first);
+        render_timing.add_time(render_time, last - first);
+        render_timing.add(text.size());
+        if (curve_tolerance > 0.0) {
+            flatten_timing.add_time(flatten_time, last - first);
+        }
+    });
+    
+    out<<"{\n";
+    for (size_t section = 0; section < sections.size(); section++) {
+        out<<indentation(1)<<json(sections[section].key).dump()<<": ";
+        if (!sections[section].is_array) {
+            out<<rendered[section].front();
+        } else if (sections[section].count == 0) {
+            out<<"[]";
+        } else {
+            out<<"[\n"<<indentation(2);
+            for (size_t chunk = 0; chunk < rendered[section].size(); chunk++) {
+                out<<(chunk == 0 ? "" : element_separator)<<rendered[section][chunk];
+            }
+            out<<"\n"<<indentation(1)<<"]";
+        }
+        out<<(section + 1 < sections.size() ? ",\n" : "\n");
+    }
+    out<<"}";
+}
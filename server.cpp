@@ -0,0 +1,262 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "server.hpp"
+#include "compression.hpp"
+#include "instrument.hpp"
+
+namespace {
+    bool send_all(int connection, const std::string &text) {
+        size_t sent = 0;
+        while (sent < text.size()) {
+            ssize_t result = ::send(connection, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(result);
+        }
+        return true;
+    }
+};
+
+bool open_json::server::parse_eda_type(const std::string &name, eda_type &type) {
+    static const std::map<std::string, eda_type> names = {
+        {"open_json", eda_type::OPEN_JSON},
+        {"eagle", eda_type::EAGLE},
+        {"kicad", eda_type::KICAD},
+        {"geda", eda_type::GEDA}
+    };
+    auto found = names.find(name);
+    if (found == names.end()) {
+        return false;
+    }
+    type = found->second;
+    return true;
+}
+
+bool open_json::server::parse_output_type(const std::string &name, output_type &type) {
+    static const std::map<std::string, output_type> names = {
+        {"schematic", output_type::SCHEMATIC},
+        {"layout", output_type::LAYOUT},
+        {"all", output_type::ALL}
+    };
+    auto found = names.find(name);
+    if (found == names.end()) {
+        return false;
+    }
+    type = found->second;
+    return true;
+}
+
+open_json::server::conversion_server::~conversion_server() {
+    this->stop();
+    std::unique_lock<std::mutex> lock(this->connections_lock);
+    this->connections_closed.wait(lock, [this]() { return this->connections.empty(); });
+}
+
+void open_json::server::conversion_server::stop() {
+    if (this->stopping.exchange(true)) {
+        return;
+    }
+    // Wakes up the blocking accept and every connection waiting for its next request, jobs in progress still finish
+    if (this->listen_socket >= 0) {
+        ::shutdown(this->listen_socket, SHUT_RDWR);
+    }
+    std::lock_guard<std::mutex> lock(this->connections_lock);
+    for (int connection : this->connections) {
+        ::shutdown(connection, SHUT_RD);
+    }
+}
+
+bool open_json::server::conversion_server::run() {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (this->socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr<<"Socket path is too long: "<<this->socket_path<<std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, this->socket_path.c_str(), sizeof(address.sun_path) - 1);
+    
+    this->listen_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (this->listen_socket < 0) {
+        std::cerr<<"Couldn't create the socket: "<<std::strerror(errno)<<std::endl;
+        return false;
+    }
+    // Only a socket left behind by an earlier server is replaced, anything else at the path is kept
+    struct stat existing;
+    if (::lstat(this->socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr<<"Couldn't listen on "<<this->socket_path<<": the path exists and is not a socket"<<std::endl;
+            ::close(this->listen_socket);
+            this->listen_socket = -1;
+            return false;
+        }
+        ::unlink(this->socket_path.c_str());
+    }
+    if (::bind(this->listen_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(this->listen_socket, 64) < 0) {
+        std::cerr<<"Couldn't listen on "<<this->socket_path<<": "<<std::strerror(errno)<<std::endl;
+        ::close(this->listen_socket);
+        this->listen_socket = -1;
+        return false;
+    }
+    std::cout<<"Listening on: "<<this->socket_path<<std::endl;
+    
+    while (!this->stopping) {
+        int connection = ::accept(this->listen_socket, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        std::lock_guard<std::mutex> lock(this->connections_lock);
+        if (this->stopping) {
+            ::close(connection);
+            break;
+        }
+        this->connections.insert(connection);
+        std::thread(&conversion_server::serve_connection, this, connection).detach();
+    }
+    
+    this->stop();
+    {
+        std::unique_lock<std::mutex> lock(this->connections_lock);
+        this->connections_closed.wait(lock, [this]() { return this->connections.empty(); });
+    }
+    ::close(this->listen_socket);
+    this->listen_socket = -1;
+    ::unlink(this->socket_path.c_str());
+    std::cout<<"Served "<<this->jobs<<" jobs, "<<this->failures<<" failed"<<std::endl;
+    return true;
+}
+
+void open_json::server::conversion_server::serve_connection(int connection) {
+    instrument::set_thread_name("connection " + std::to_string(connection));
+    std::string pending;
+    char buffer[1 << 16];
+    bool open = true;
+    while (open) {
+        ssize_t received = ::recv(connection, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(buffer, static_cast<size_t>(received));
+        size_t line_end;
+        while (open && (line_end = pending.find('\n')) != std::string::npos) {
+            std::string line = pending.substr(0, line_end);
+            pending.erase(0, line_end + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            json response;
+            try {
+                json request = json::parse(line);
+                if (open_json::get_value_or_default<std::string>(request, "command", "") == "shutdown") {
+                    response = {{"ok", true}};
+                    open = false;
+                    this->stop();
+                } else {
+                    response = this->run_job(request);
+                }
+            } catch (std::exception &e) {
+                response = {{"ok", false}, {"error", std::string("Invalid request: ") + e.what()}};
+            }
+            if (!send_all(connection, response.dump() + "\n")) {
+                open = false;
+            }
+        }
+        if (open && pending.size() > max_request_size) {
+            send_all(connection, json({{"ok", false}, {"error", "Request exceeds " + std::to_string(max_request_size) + " bytes"}}).dump() + "\n");
+            open = false;
+        }
+    }
+    std::lock_guard<std::mutex> lock(this->connections_lock);
+    ::close(connection);
+    this->connections.erase(connection);
+    this->connections_closed.notify_all();
+}
+
+json open_json::server::conversion_server::run_job(const json &request) {
+    this->jobs++;
+    eda_type input_type = eda_type::OPEN_JSON;
+    output_type requested_output = output_type::ALL;
+    if (!parse_eda_type(open_json::get_value_or_default<std::string>(request, "eda_type", "open_json"), input_type) || input_type != eda_type::OPEN_JSON) {
+        this->failures++;
+        return {{"ok", false}, {"error", "Unsupported eda_type, only open_json is available"}};
+    }
+    if (!parse_output_type(open_json::get_value_or_default<std::string>(request, "output_type", "all"), requested_output)) {
+        this->failures++;
+        return {{"ok", false}, {"error", "Unknown output_type"}};
+    }
+    
+    converter_options job_options = this->options;
+    job_options.curve_tolerance = open_json::get_value_or_default(request, "flatten_curves", job_options.curve_tolerance);
+    if (!open_json::compression::parse_compression_type(open_json::get_value_or_default<std::string>(request, "compression", "none"), job_options.output_compression)) {
+        this->failures++;
+        return {{"ok", false}, {"error", "Unknown compression"}};
+    }
+    open_json::open_json_format format(job_options);
+    open_json::diagnostic_capture diagnostics;
+    json response = {{"ok", true}};
+    try {
+        std::shared_ptr<open_json::data> design;
+        {
+            open_json::diagnostic_capture::scope capture(diagnostics);
+            if (request.find("input") != request.end()) {
+                std::string input = request["input"];
+                std::ifstream file_stream(input, std::ios::binary);
+                if (!file_stream) {
+                    throw parse_exception("Couldn't open " + input);
+                }
+                open_json::compression::input_stream decompressed(file_stream);
+                design = format.read_file(input, decompressed, requested_output);
+            } else if (request.find("data") != request.end()) {
+                std::string input = request["data"].is_string() ? request["data"].get<std::string>() : request["data"].dump();
+                design = format.read_buffer("inline", input, requested_output);
+            } else {
+                throw parse_exception("The job has neither an input path nor inline data");
+            }
+        }
+        if (request.find("output") != request.end()) {
+            std::string output = request["output"];
+            std::ofstream file_stream(output, std::ios::binary);
+            if (job_options.output_compression == compression_type::NONE) {
+                format.write_stream(*design, requested_output, file_stream);
+            } else {
+                open_json::compression::output_stream compressed(file_stream, job_options.output_compression);
+                format.write_stream(*design, requested_output, compressed);
+                compressed.close();
+            }
+            if (!file_stream) {
+                throw std::runtime_error("Couldn't write " + output);
+            }
+            response["output"] = output;
+        } else {
+            std::ostringstream output;
+            format.write_stream(*design, requested_output, output);
+            response["result"] = output.str();
+        }
+    } catch (std::exception &e) {
+        this->failures++;
+        response = {{"ok", false}, {"error", e.what()}};
+    }
+    response["messages"] = diagnostics.get_text();
+    return response;
+}
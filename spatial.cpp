@@ -0,0 +1,211 @@
+#include <cmath>
+#include <queue>
+
+#include "bounds.hpp"
+#include "parallel.hpp"
+#include "spatial.hpp"
+
+namespace {
+    using open_json::types::bounding_box;
+
+    inline int64_t center_x(const bounding_box &box) { return box.min_x / 2 + box.max_x / 2; }
+    inline int64_t center_y(const bounding_box &box) { return box.min_y / 2 + box.max_y / 2; }
+
+    inline double distance_squared(const bounding_box &box, const open_json::types::point &p) {
+        double dx = std::max<double>(0.0, std::max<double>(box.min_x - p.x, p.x - box.max_x));
+        double dy = std::max<double>(0.0, std::max<double>(box.min_y - p.y, p.y - box.max_y));
+        return dx * dx + dy * dy;
+    }
+
+    // Orders items so that every run of node_capacity items forms one node of the next level
+    template<typename item_type, typename bounds_function>
+    void sort_tile_recursive(std::vector<item_type> &items, bounds_function get_bounds) {
+        const size_t capacity = open_json::spatial::rtree::node_capacity;
+        size_t node_count = (items.size() + capacity - 1) / capacity;
+        size_t slice_size = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(node_count)))) * capacity;
+        size_t slice_count = (items.size() + slice_size - 1) / slice_size;
+
+        std::sort(items.begin(), items.end(), [&get_bounds](const item_type &a, const item_type &b) {
+            return center_x(get_bounds(a)) < center_x(get_bounds(b));
+        });
+        auto sort_slice = [&](size_t slice) {
+            auto begin = items.begin() + slice * slice_size;
+            auto end = items.begin() + std::min(items.size(), (slice + 1) * slice_size);
+            std::sort(begin, end, [&get_bounds](const item_type &a, const item_type &b) {
+                return center_y(get_bounds(a)) < center_y(get_bounds(b));
+            });
+        };
+        if (items.size() >= open_json::spatial::rtree::parallel_threshold) {
+            open_json::parallel::for_each_index(slice_count, sort_slice);
+        } else {
+            for (size_t slice = 0; slice < slice_count; slice++) {
+                sort_slice(slice);
+            }
+        }
+    }
+
+    template<typename object_type>
+    void collect_entries(const std::vector<std::shared_ptr<object_type>> &objects, const std::vector<bounding_box> &bounds, open_json::spatial::object_type type, std::map<std::string, std::vector<open_json::spatial::entry>> &layers) {
+        for (size_t index = 0; index < objects.size(); index++) {
+            if (!bounds[index].is_empty()) {
+                layers[objects[index]->get_layer_name()].emplace_back(bounds[index], type, index);
+            }
+        }
+    }
+};
+
+// R-Tree
+const size_t open_json::spatial::rtree::node_capacity;
+const size_t open_json::spatial::rtree::parallel_threshold;
+
+open_json::spatial::rtree::rtree(std::vector<entry> items) : entries(std::move(items)) {
+    if (this->entries.empty()) {
+        return;
+    }
+
+    std::vector<node> level;
+    sort_tile_recursive(this->entries, [](const entry &e) -> const bounding_box & { return e.bounds; });
+    for (size_t first = 0; first < this->entries.size(); first += node_capacity) {
+        node leaf;
+        leaf.first = first;
+        leaf.count = std::min(node_capacity, this->entries.size() - first);
+        for (size_t i = first; i < first + leaf.count; i++) {
+            leaf.bounds.expand(this->entries[i].bounds);
+        }
+        level.push_back(leaf);
+    }
+
+    while (level.size() > 1) {
+        sort_tile_recursive(level, [](const node &n) -> const bounding_box & { return n.bounds; });
+        size_t base = this->nodes.size();
+        this->nodes.insert(this->nodes.end(), level.begin(), level.end());
+        std::vector<node> parents;
+        for (size_t first = 0; first < level.size(); first += node_capacity) {
+            node parent;
+            parent.first = base + first;
+            parent.count = std::min(node_capacity, level.size() - first);
+            parent.leaf = false;
+            for (size_t i = first; i < first + parent.count; i++) {
+                parent.bounds.expand(level[i].bounds);
+            }
+            parents.push_back(parent);
+        }
+        level.swap(parents);
+    }
+    this->nodes.push_back(level.front());
+}
+
+void open_json::spatial::rtree::query(const types::bounding_box &window, std::vector<entry> &results) const {
+    if (this->nodes.empty()) {
+        return;
+    }
+    std::vector<size_t> stack(1, this->nodes.size() - 1);
+    while (!stack.empty()) {
+        const node &current = this->nodes[stack.back()];
+        stack.pop_back();
+        if (!current.bounds.intersects(window)) {
+            continue;
+        }
+        for (size_t i = current.first; i < current.first + current.count; i++) {
+            if (current.leaf) {
+                if (this->entries[i].bounds.intersects(window)) {
+                    results.push_back(this->entries[i]);
+                }
+            } else {
+                stack.push_back(i);
+            }
+        }
+    }
+}
+
+std::vector<open_json::spatial::entry> open_json::spatial::rtree::nearest(const types::point &position, size_t count) const {
+    // Best first search, leaf entries are queued with the entry index offset past the node indices
+    typedef std::pair<double, size_t> candidate;
+    std::priority_queue<candidate, std::vector<candidate>, std::greater<candidate>> queue;
+    std::vector<entry> results;
+    if (this->nodes.empty() || count == 0) {
+        return results;
+    }
+    const size_t entry_offset = this->nodes.size();
+    queue.emplace(distance_squared(this->nodes.back().bounds, position), this->nodes.size() - 1);
+    while (!queue.empty() && results.size() < count) {
+        size_t index = queue.top().second;
+        queue.pop();
+        if (index >= entry_offset) {
+            results.push_back(this->entries[index - entry_offset]);
+            continue;
+        }
+        const node &current = this->nodes[index];
+        for (size_t i = current.first; i < current.first + current.count; i++) {
+            if (current.leaf) {
+                queue.emplace(distance_squared(this->entries[i].bounds, position), entry_offset + i);
+            } else {
+                queue.emplace(distance_squared(this->nodes[i].bounds, position), i);
+            }
+        }
+    }
+    return results;
+}
+
+// Spatial Index
+open_json::spatial::spatial_index::spatial_index(open_json::data &file) {
+    // The object bounds are shared with the extents cache, which computes them in parallel
+    std::shared_ptr<bounds::extents> extents = file.get_extents();
+    std::map<std::string, std::vector<entry>> layer_entries;
+    collect_entries(file.get_traces(), extents->traces, object_type::TRACE, layer_entries);
+    collect_entries(file.get_pours(), extents->pours, object_type::POUR, layer_entries);
+    collect_entries(file.get_paths(), extents->paths, object_type::PATH, layer_entries);
+    collect_entries(file.get_layout_bodies(), extents->layout_bodies, object_type::LAYOUT_BODY, layer_entries);
+    collect_entries(file.get_pcb_text(), extents->pcb_text, object_type::PCB_TEXT, layer_entries);
+
+    for (auto &layer : layer_entries) {
+        this->layers[layer.first] = rtree(std::move(layer.second));
+    }
+}
+
+std::vector<std::string> open_json::spatial::spatial_index::get_layer_names() const {
+    std::vector<std::string> names;
+    for (auto &layer : this->layers) {
+        names.push_back(layer.first);
+    }
+    return names;
+}
+
+const open_json::spatial::rtree *open_json::spatial::spatial_index::get_layer(const std::string &layer_name) const {
+    auto layer = this->layers.find(layer_name);
+    return layer == this->layers.end() ? nullptr : &layer->second;
+}
+
+std::vector<open_json::spatial::entry> open_json::spatial::spatial_index::query(const std::string &layer_name, const types::bounding_box &window) const {
+    std::vector<entry> results;
+    const rtree *layer = this->get_layer(layer_name);
+    if (layer != nullptr) {
+        layer->query(window, results);
+    }
+    return results;
+}
+
+std::vector<open_json::spatial::entry> open_json::spatial::spatial_index::query(const std::string &layer_name, const types::point &position) const {
+    return this->query(layer_name, types::bounding_box(position.x, position.y, position.x, position.y));
+}
+
+std::vector<open_json::spatial::entry> open_json::spatial::spatial_index::nearest(const std::string &layer_name, const types::point &position, size_t count) const {
+    const rtree *layer = this->get_layer(layer_name);
+    return layer == nullptr ? std::vector<entry>() : layer->nearest(position, count);
+}
+
+open_json::types::json_object *open_json::spatial::resolve(open_json::data &file, const entry &item) {
+    switch (item.type) {
+        case object_type::TRACE:
+            return file.get_traces()[item.index].get();
+        case object_type::POUR:
+            return file.get_pours()[item.index].get();
+        case object_type::PATH:
+            return file.get_paths()[item.index].get();
+        case object_type::LAYOUT_BODY:
+            return file.get_layout_bodies()[item.index].get();
+        case object_type::PCB_TEXT:
+        default:
+            return file.get_pcb_text()[item.index].get();
+    }
+}
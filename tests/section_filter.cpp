@@ -0,0 +1,71 @@
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "openjson.hpp"
+
+// Checks that the section callback skips rejected sections instead of building them, e.g. make test
+namespace {
+    size_t failures = 0;
+    
+    void check(bool condition, const std::string &description) {
+        if (!condition) {
+            std::cerr<<"FAILED: "<<description<<std::endl;
+            failures++;
+        }
+    }
+    
+    // Parses with the section callback of keep_section, counting every event the parser reports
+    json parse_filtered(const std::string &text, std::function<bool(const std::string &)> keep_section, size_t &events) {
+        json::parser_callback_t filter = open_json::get_section_callback(keep_section);
+        events = 0;
+        return json::parse(text, [&](int depth, json::parse_event_t event, json &parsed) {
+            events++;
+            return filter(depth, event, parsed);
+        });
+    }
+    
+    // Same result as lexing everything and erasing the rejected keys afterwards
+    void check_matches_full_parse(const std::string &text, const std::set<std::string> &kept) {
+        size_t events = 0;
+        json filtered = parse_filtered(text, [&kept](const std::string &key) { return kept.count(key) > 0; }, events);
+        json expected = json::parse(text);
+        for (json::iterator it = expected.begin(); it != expected.end();) {
+            it = kept.count(it.key()) > 0 ? std::next(it) : expected.erase(it);
+        }
+        check(filtered == expected, "filtering " + text + " keeps exactly the accepted sections");
+    }
+};
+
+int main() {
+    std::string dropped = "[";
+    for (size_t i = 0; i < 1000; i++) {
+        dropped += std::string(i == 0 ? "" : ",") + "{\"a\": [1, 2, 3]}";
+    }
+    dropped += "]";
+    std::string text = "{\"keep\": 1, \"drop\": " + dropped + ", \"after\": {\"b\": [4]}}";
+    size_t events = 0;
+    json parsed = parse_filtered(text, [](const std::string &key) { return key != "drop"; }, events);
+    check(parsed == json::parse("{\"keep\": 1, \"after\": {\"b\": [4]}}"), "the dropped section is left out");
+    // Root start and end, three keys, the scalar, the start of the dropped array and the object after it with its array
+    check(events < 20, "the dropped section reported " + std::to_string(events) + " events, its contents must not be visited");
+    
+    // Empty arrays inside a dropped value still move the depth json.hpp reports, the keys after it must stay top level
+    const std::string nested = "{\"a\": [[], {}, [[]]], \"b\": {\"x\": [], \"y\": {\"z\": 1}}, \"c\": [1, {\"d\": 2}], \"d\": {}, \"e\": [], \"f\": 5, \"g\": {\"a\": {\"b\": []}}}";
+    const std::vector<std::set<std::string>> selections = {
+        {}, {"a"}, {"b"}, {"c"}, {"d", "g"}, {"e", "f"}, {"a", "c", "g"}, {"b", "d", "f"}, {"a", "b", "c", "d", "e", "f", "g"}
+    };
+    for (const std::set<std::string> &kept : selections) {
+        check_matches_full_parse(nested, kept);
+    }
+    
+    if (failures != 0) {
+        std::cerr<<failures<<" checks failed"<<std::endl;
+        return 1;
+    }
+    std::cout<<"All section filter checks passed"<<std::endl;
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TRANSFORM_HAVE_AVX2_KERNEL
+#endif
+
+#include "parallel.hpp"
+#include "transform.hpp"
+
+namespace {
+    using open_json::transform::affine;
+    using open_json::types::point;
+
+    static_assert(sizeof(point) == 2 * sizeof(int64_t), "The SIMD kernels expect points to be packed x, y pairs");
+
+    // Adding 2^52 + 2^51 to a double in that range leaves the integer in the low mantissa bits
+    const double magic_double = 6755399441055744.0;
+    const int64_t magic_bits = 0x4338000000000000LL;
+
+#ifdef TRANSFORM_HAVE_AVX2_KERNEL
+    // Each 256 bit register holds two points as x, y, x, y lanes
+    __attribute__((target("avx2")))
+    void apply_avx2(const affine &matrix, const point *input, point *output, size_t count) {
+        const __m256i integer_magic = _mm256_set1_epi64x(magic_bits);
+        const __m256d double_magic = _mm256_set1_pd(magic_double);
+        const __m256d diagonal = _mm256_setr_pd(matrix.xx, matrix.yy, matrix.xx, matrix.yy);
+        const __m256d cross = _mm256_setr_pd(matrix.xy, matrix.yx, matrix.xy, matrix.yx);
+        const __m256d translation = _mm256_setr_pd(matrix.tx, matrix.ty, matrix.tx, matrix.ty);
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+            __m256d coordinates = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(values, integer_magic)), double_magic);
+            __m256d swapped = _mm256_permute_pd(coordinates, 0x5);
+            __m256d result = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(diagonal, coordinates), _mm256_mul_pd(cross, swapped)), translation);
+            __m256i rounded = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(result, double_magic)), integer_magic);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), rounded);
+        }
+        open_json::transform::apply_scalar(matrix, input + i, output + i, count - i);
+    }
+#endif
+
+    typedef void (*apply_function)(const affine &matrix, const point *input, point *output, size_t count);
+
+    apply_function select_kernel() {
+#ifdef TRANSFORM_HAVE_AVX2_KERNEL
+        if (__builtin_cpu_supports("avx2")) {
+            return &apply_avx2;
+        }
+#endif
+        return &open_json::transform::apply_scalar;
+    }
+
+    // Exact values for the right angles placements almost always use
+    void rotation_terms(double rotation, double &cosine, double &sine) {
+        double quarter_turns = rotation * 2.0;
+        if (quarter_turns == std::floor(quarter_turns)) {
+            static const double cosines[4] = {1.0, 0.0, -1.0, 0.0};
+            static const double sines[4] = {0.0, 1.0, 0.0, -1.0};
+            int index = static_cast<int>(std::fmod(std::fmod(quarter_turns, 4.0) + 4.0, 4.0));
+            cosine = cosines[index];
+            sine = sines[index];
+            return;
+        }
+        cosine = std::cos(open_json::angle_to_radians(rotation));
+        sine = std::sin(open_json::angle_to_radians(rotation));
+    }
+
+    void place_body(std::shared_ptr<open_json::types::body> body, const affine &matrix, double rotation, bool mirrored, std::vector<open_json::transform::world_shape> &shapes, std::vector<point> &scratch) {
+        // Gather every vertex of the body so the whole body is transformed in one batch
+        scratch.clear();
+        std::vector<size_t> offsets;
+        for (size_t index = 0; index < body->get_number_of_shapes(); index++) {
+            offsets.push_back(scratch.size());
+            body->get_shape_at_index(index)->get_vertices(scratch);
+        }
+        offsets.push_back(scratch.size());
+        open_json::transform::apply(matrix, scratch.data(), scratch.data(), scratch.size());
+
+        for (size_t index = 0; index < body->get_number_of_shapes(); index++) {
+            open_json::transform::world_shape shape;
+            shape.shape = body->get_shape_at_index(index);
+            shape.layer_name = body->get_layer_name();
+            shape.vertices.assign(scratch.begin() + offsets[index], scratch.begin() + offsets[index + 1]);
+            shape.rotation = rotation + body->get_rotation();
+            shape.mirrored = mirrored != body->get_flip();
+            shapes.push_back(std::move(shape));
+        }
+    }
+
+    void place_instance(open_json::transform::placed_instance &placed, std::vector<point> &scratch) {
+        std::shared_ptr<open_json::types::component> definition = placed.instance->get_definition();
+        if (!definition) {
+            return;
+        }
+
+        placed.footprint_transform = affine::placement(placed.instance->get_footprint_position(), placed.instance->get_footprint_rotation(), placed.instance->is_footprint_mirrored());
+        open_json::types::footprint *footprint = definition->get_footprint_at_index(placed.instance->get_footprint_index());
+        if (footprint != nullptr) {
+            for (size_t index = 0; index < footprint->get_number_of_bodies(); index++) {
+                std::shared_ptr<open_json::types::body> body = footprint->get_body_at_index(index);
+                affine body_transform = affine::placement(point(), body->get_rotation(), body->get_flip());
+                place_body(body, body_transform.then(placed.footprint_transform), placed.instance->get_footprint_rotation(), placed.instance->is_footprint_mirrored(), placed.footprint_shapes, scratch);
+            }
+        }
+
+        // Every body of the symbol has its own placement in the matching symbol attribute
+        std::shared_ptr<open_json::types::symbol> symbol = definition->get_symbol_at_index(placed.instance->get_symbol_index());
+        if (symbol) {
+            for (size_t index = 0; index < symbol->get_number_of_bodies(); index++) {
+                open_json::types::symbol_attribute *attribute = placed.instance->get_symbol_attribute_at_index(index);
+                if (attribute == nullptr) {
+                    break;
+                }
+                affine symbol_transform = affine::placement(attribute->get_position(), attribute->get_rotation(), attribute->get_flip());
+                place_body(symbol->get_body_at_index(index), symbol_transform, attribute->get_rotation(), attribute->get_flip(), placed.symbol_shapes, scratch);
+            }
+        }
+    }
+};
+
+open_json::transform::affine open_json::transform::affine::placement(const types::point &position, double rotation, bool mirror) {
+    double cosine, sine;
+    rotation_terms(rotation, cosine, sine);
+    double mirror_sign = mirror ? -1.0 : 1.0;
+    affine matrix;
+    matrix.xx = cosine * mirror_sign;
+    matrix.xy = -sine;
+    matrix.yx = sine * mirror_sign;
+    matrix.yy = cosine;
+    matrix.tx = static_cast<double>(position.x);
+    matrix.ty = static_cast<double>(position.y);
+    return matrix;
+}
+
+open_json::transform::affine open_json::transform::affine::then(const affine &outer) const {
+    affine matrix;
+    matrix.xx = outer.xx * this->xx + outer.xy * this->yx;
+    matrix.xy = outer.xx * this->xy + outer.xy * this->yy;
+    matrix.tx = outer.xx * this->tx + outer.xy * this->ty + outer.tx;
+    matrix.yx = outer.yx * this->xx + outer.yy * this->yx;
+    matrix.yy = outer.yx * this->xy + outer.yy * this->yy;
+    matrix.ty = outer.yx * this->tx + outer.yy * this->ty + outer.ty;
+    return matrix;
+}
+
+void open_json::transform::apply_scalar(const affine &matrix, const types::point *input, types::point *output, size_t count) {
+    // Kept as separate statements so the compiler can't contract them into fused multiply adds, which would round differently from the SIMD path
+    for (size_t i = 0; i < count; i++) {
+        double x = static_cast<double>(input[i].x), y = static_cast<double>(input[i].y);
+        double x_diagonal = matrix.xx * x, x_cross = matrix.xy * y;
+        double y_diagonal = matrix.yy * y, y_cross = matrix.yx * x;
+        double x_linear = x_diagonal + x_cross, y_linear = y_diagonal + y_cross;
+        output[i].x = static_cast<int64_t>(std::nearbyint(x_linear + matrix.tx));
+        output[i].y = static_cast<int64_t>(std::nearbyint(y_linear + matrix.ty));
+    }
+}
+
+void open_json::transform::apply(const affine &matrix, const types::point *input, types::point *output, size_t count) {
+    static const apply_function kernel = select_kernel();
+    kernel(matrix, input, output, count);
+}
+
+std::shared_ptr<open_json::transform::world_geometry> open_json::transform::place_instances(open_json::data &file) {
+    std::shared_ptr<world_geometry> geometry(new world_geometry());
+    for (auto &component_instance : file.get_component_instances()) {
+        placed_instance placed;
+        placed.instance = component_instance.second;
+        geometry->instances.push_back(placed);
+    }
+
+    size_t batch_count = (geometry->instances.size() + instance_batch_size - 1) / instance_batch_size;
+    open_json::parallel::for_each_index(batch_count, [&geometry](size_t batch) {
+        std::vector<types::point> scratch;
+        size_t end = std::min(geometry->instances.size(), (batch + 1) * instance_batch_size);
+        for (size_t index = batch * instance_batch_size; index < end; index++) {
+            place_instance(geometry->instances[index], scratch);
+        }
+    });
+    return geometry;
+}